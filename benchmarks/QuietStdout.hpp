@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Silences stdout while in scope, as the library logs every load there
+class QuietStdout
+{
+public:
+	QuietStdout()
+	{
+		fflush(stdout);
+		saved_fd = dup(STDOUT_FILENO);
+		int null_fd = open("/dev/null", O_WRONLY);
+		dup2(null_fd, STDOUT_FILENO);
+		close(null_fd);
+	}
+
+	~QuietStdout()
+	{
+		fflush(stdout);
+		dup2(saved_fd, STDOUT_FILENO);
+		close(saved_fd);
+	}
+
+private:
+	int saved_fd;
+};
@@ -0,0 +1,273 @@
+// Measures, for each load mode, the time taken to read an executable's
+// debugging information, the peak memory used, and the latency of the queries
+// made while debugging it. The results are written to stdout as JSON, so that
+// they can be compared between builds.
+//
+// Usage: debug_info_load <executable> [queries] [variable]
+//
+// The variable is looked up by its qualified name, and defaults to the global
+// of the first synthetic compilation unit. A mode in which it can't be found
+// is reported as null, and makes the benchmark fail.
+//
+// Each mode is measured in a process of its own, so that its peak RSS isn't
+// inflated by the modes measured before it.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "DebugInfo.hpp"
+#include "ProcessTracer.hpp"
+
+#include "QuietStdout.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsBetween(Clock::time_point start_time, Clock::time_point end_time)
+{
+	std::chrono::duration<double, std::milli> elapsed = end_time - start_time;
+	return elapsed.count();
+}
+
+template <typename Query>
+static double microsecondsToRun(Query query)
+{
+	auto start_time = Clock::now();
+	query();
+	std::chrono::duration<double, std::micro> elapsed = Clock::now() - start_time;
+	return elapsed.count();
+}
+
+static long peakRSSKilobytes()
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static std::string latencyJson(std::vector<double> samples)
+{
+	if (samples.empty())
+		return "{\"count\": 0}";
+
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](double fraction)
+	{
+		size_t index = static_cast<size_t>(fraction * samples.size());
+		return samples[std::min(index, samples.size() - 1)];
+	};
+	double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+
+	char json[256];
+	snprintf(json, sizeof(json),
+	         "{\"count\": %zu, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}",
+	         samples.size(), mean, percentile(0.5), percentile(0.99), samples.back());
+	return json;
+}
+
+static std::string jsonString(const std::string &str)
+{
+	std::string json = "\"";
+	for (char c : str)
+	{
+		if (c == '"' || c == '\\')
+			json += '\\';
+		json += c;
+	}
+	return json + "\"";
+}
+
+// Loads the debugging information in one mode and queries it. Queries are
+// spread over the source files in a fixed order, so that every mode answers
+// the same ones.
+static std::string measureMode(const std::string &executable, DebugInfo::LoadMode mode,
+                               unsigned int query_count, const std::string &variable_name)
+{
+	long rss_before_load = peakRSSKilobytes();
+
+	// The last progress report is made once the indices are ready, which is
+	// only after loading when indexing in the background
+	std::atomic<int64_t> ready_ns(-1);
+	auto start_time = Clock::now();
+	auto progress = [&](size_t indexed_units, size_t total_units)
+	{
+		if (indexed_units == total_units)
+			ready_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_time).count();
+	};
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom(executable, mode, "", progress);
+	double load_ms = millisecondsBetween(start_time, Clock::now());
+
+	std::vector<std::string> source_files = debug_info->getSourceFiles();
+	std::mt19937 random(1);
+	std::vector<uint64_t> addresses;
+	std::vector<double> source_file_lines_us;
+	for (unsigned int i = 0; i < query_count && !source_files.empty(); i++)
+	{
+		const std::string &source_file = source_files[random() % source_files.size()];
+		DebugInfo::SourceLines lines;
+		source_file_lines_us.push_back(microsecondsToRun([&]()
+		{
+			lines = debug_info->getSourceFileLines(source_file);
+		}));
+		if (!lines.empty())
+			addresses.push_back(lines[random() % lines.size()].address);
+	}
+
+	std::vector<double> function_us;
+	for (uint64_t address : addresses)
+		function_us.push_back(microsecondsToRun([&]() { debug_info->getFunction(address); }));
+
+	// Values are read from a process stopped on its first instruction, so are
+	// meaningless, but finding the variable and its type is the same work. A
+	// variable which isn't found would only measure failed lookups, so the
+	// mode fails instead.
+	std::vector<double> variable_us;
+	size_t unresolved_variables = 0;
+	pid_t benchmark_pid = getpid();
+	ProcessTracer tracer;
+	if (tracer.start(executable))
+	{
+		pid_t pid = tracer.traceePID();
+		for (uint64_t address : addresses)
+		{
+			DebugInfo::Variable variable;
+			variable_us.push_back(microsecondsToRun([&]()
+			{
+				variable = debug_info->getVariable(variable_name, tracer, address);
+			}));
+			if (variable.value == "Variable not locatable")
+				unresolved_variables++;
+		}
+		kill(pid, SIGKILL);
+		waitpid(pid, nullptr, 0);
+	}
+	else if (getpid() != benchmark_pid)
+	{
+		// The target couldn't be executed in the forked process
+		_exit(1);
+	}
+
+	if (unresolved_variables > 0)
+	{
+		fprintf(stderr, "%s wasn't found in %zu of %zu queries\n", variable_name.c_str(),
+		        unresolved_variables, variable_us.size());
+		_exit(1);
+	}
+
+	debug_info->waitUntilIndexed();
+	long peak_rss = peakRSSKilobytes();
+
+	char json[256];
+	std::string ready_ms = (ready_ns >= 0) ? std::to_string(ready_ns / 1e6) : "null";
+	snprintf(json, sizeof(json),
+	         "{\"load_ms\": %.2f, \"ready_ms\": %s, \"rss_before_load_kb\": %ld, \"peak_rss_kb\": %ld, ",
+	         load_ms, ready_ms.c_str(), rss_before_load, peak_rss);
+	return std::string(json) +
+	       "\"source_files\": " + std::to_string(source_files.size()) + ", " +
+	       "\"queries\": {" +
+	       "\"getSourceFileLines\": " + latencyJson(source_file_lines_us) + ", " +
+	       "\"getFunction\": " + latencyJson(function_us) + ", " +
+	       "\"getVariable\": " + latencyJson(variable_us) + "}}";
+}
+
+// Measures a mode in a child process, which sends back its results as JSON
+static std::string measureModeInChild(const std::string &executable, DebugInfo::LoadMode mode,
+                                      unsigned int query_count, const std::string &variable_name)
+{
+	int fds[2];
+	if (pipe(fds) < 0)
+		return "null";
+
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(fds[0]);
+		std::string json;
+		{
+			QuietStdout quiet;
+			json = measureMode(executable, mode, query_count, variable_name);
+		}
+		size_t written = 0;
+		while (written < json.size())
+		{
+			ssize_t result = write(fds[1], json.data() + written, json.size() - written);
+			if (result <= 0)
+				break;
+			written += result;
+		}
+		close(fds[1]);
+		_exit(0);
+	}
+
+	close(fds[1]);
+	std::string json;
+	char buffer[4096];
+	ssize_t result;
+	while (pid > 0 && (result = read(fds[0], buffer, sizeof(buffer))) > 0)
+		json.append(buffer, result);
+	close(fds[0]);
+
+	int status = 0;
+	if (pid > 0)
+		waitpid(pid, &status, 0);
+	bool succeeded = pid > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	return (succeeded && !json.empty()) ? json : "null";
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <executable> [queries] [variable]\n", argv[0]);
+		return 1;
+	}
+
+	std::string executable = argv[1];
+	unsigned int query_count = 1000;
+	if (argc > 2)
+		query_count = std::max(1, atoi(argv[2]));
+	std::string variable_name = "unit_0::global_counter";
+	if (argc > 3)
+		variable_name = argv[3];
+
+	struct
+	{
+		const char *name;
+		DebugInfo::LoadMode mode;
+	} modes[] = {
+		{"indexed", DebugInfo::LOAD_INDEXED},
+		{"flattened", DebugInfo::LOAD_FLATTENED},
+		{"lazy", DebugInfo::LOAD_LAZY},
+		{"background", DebugInfo::LOAD_BACKGROUND}
+	};
+
+	printf("{\n");
+	printf("  \"executable\": %s,\n", jsonString(executable).c_str());
+	printf("  \"queries\": %u,\n", query_count);
+	printf("  \"variable\": %s,\n", jsonString(variable_name).c_str());
+	printf("  \"modes\": {\n");
+	size_t mode_count = sizeof(modes) / sizeof(modes[0]);
+	bool has_failed = false;
+	for (size_t i = 0; i < mode_count; i++)
+	{
+		std::string json = measureModeInChild(executable, modes[i].mode, query_count, variable_name);
+		printf("    \"%s\": %s%s\n", modes[i].name, json.c_str(), (i + 1 < mode_count) ? "," : "");
+		has_failed = has_failed || json == "null";
+	}
+	printf("  }\n");
+	printf("}\n");
+	return has_failed ? 1 : 0;
+}
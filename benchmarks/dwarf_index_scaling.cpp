@@ -0,0 +1,69 @@
+// Measures how the time taken to load and index an executable's DWARF
+// information scales with the number of indexing workers.
+//
+// Usage: dwarf_index_scaling <executable> [max_threads] [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dwarf/DwarfDebug.hpp"
+
+#include "QuietStdout.hpp"
+
+// Returns the fastest of several loads, in milliseconds
+static double timeLoad(const std::string &executable, unsigned int threads, unsigned int repetitions)
+{
+	DwarfLoadOptions options;
+	options.index_threads = threads;
+
+	double best = std::numeric_limits<double>::max();
+	for (unsigned int i = 0; i < repetitions; i++)
+	{
+		QuietStdout quiet;
+		auto start_time = std::chrono::steady_clock::now();
+		DwarfDebug dwarf(executable, options);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+		best = std::min(best, elapsed.count());
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <executable> [max_threads] [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::string executable = argv[1];
+	unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	if (argc > 2)
+		max_threads = std::max(1, atoi(argv[2]));
+	unsigned int repetitions = 3;
+	if (argc > 3)
+		repetitions = std::max(1, atoi(argv[3]));
+
+	// Double the number of threads each time, always finishing on the maximum
+	std::vector<unsigned int> thread_counts;
+	for (unsigned int threads = 1; threads < max_threads; threads *= 2)
+		thread_counts.push_back(threads);
+	thread_counts.push_back(max_threads);
+
+	printf("%-8s %12s %8s\n", "threads", "load (ms)", "speedup");
+	double baseline = 0.0;
+	for (unsigned int threads : thread_counts)
+	{
+		double elapsed = timeLoad(executable, threads, repetitions);
+		if (threads == 1)
+			baseline = elapsed;
+		printf("%-8u %12.1f %7.2fx\n", threads, elapsed, baseline / elapsed);
+	}
+	return 0;
+}
@@ -0,0 +1,148 @@
+# Generates the compilation units of the synthetic executable. It is run in
+# script mode by the synthetic_sources target, with PARAMETERS naming the file
+# which sets OUTPUT_DIR and the SYNTHETIC_* variables.
+#
+# Every unit has the same shape, and differs only in its namespace:
+# - SYNTHETIC_TYPES_PER_CU record structs, along with one class
+# - SYNTHETIC_FUNCTIONS_PER_CU functions, each nesting SYNTHETIC_SCOPE_DEPTH
+#   lexical blocks with a local variable in each
+# - SYNTHETIC_TEMPLATE_INSTANCES explicit instantiations of a class template
+#
+# Units are written through configure_file, which leaves them untouched when
+# their contents haven't changed, so regenerating doesn't recompile them all.
+
+include(${PARAMETERS})
+
+set(TYPE_COUNT ${SYNTHETIC_TYPES_PER_CU})
+if(TYPE_COUNT LESS 1)
+	set(TYPE_COUNT 1)
+endif()
+
+set(UNIT_TEMPLATE "// Generated by GenerateUnits.cmake for compilation unit @UNIT@\n")
+string(APPEND UNIT_TEMPLATE "#include <cstdint>\n\nnamespace unit_@UNIT@\n{\n")
+
+# Record types, which form linked lists walked by the functions
+math(EXPR LAST_TYPE "${TYPE_COUNT} - 1")
+foreach(TYPE RANGE ${LAST_TYPE})
+	string(APPEND UNIT_TEMPLATE
+		"\tstruct Record${TYPE}\n"
+		"\t{\n"
+		"\t\tint32_t id;\n"
+		"\t\tdouble weight;\n"
+		"\t\tconst char *label;\n"
+		"\t\tRecord${TYPE} *next;\n"
+		"\t};\n\n")
+endforeach()
+
+string(APPEND UNIT_TEMPLATE
+	"\tclass Accumulator\n"
+	"\t{\n"
+	"\tpublic:\n"
+	"\t\tAccumulator(int32_t seed) : total(seed) {}\n\n"
+	"\t\tvoid add(int32_t id, double weight)\n"
+	"\t\t{\n"
+	"\t\t\tint32_t scaled = static_cast<int32_t>(weight * id);\n"
+	"\t\t\ttotal += scaled;\n"
+	"\t\t}\n\n"
+	"\t\tint32_t result() const\n"
+	"\t\t{\n"
+	"\t\t\treturn total;\n"
+	"\t\t}\n\n"
+	"\tprivate:\n"
+	"\t\tint32_t total;\n"
+	"\t};\n\n")
+
+# A class template, explicitly instantiated for arrays of different lengths
+# and element types so that every instance is emitted
+string(APPEND UNIT_TEMPLATE
+	"\ttemplate <typename T, int N>\n"
+	"\tstruct Buffer\n"
+	"\t{\n"
+	"\t\tT values[N];\n\n"
+	"\t\tT sum() const\n"
+	"\t\t{\n"
+	"\t\t\tT total = T();\n"
+	"\t\t\tfor (int i = 0; i < N; i++)\n"
+	"\t\t\t{\n"
+	"\t\t\t\tT value = values[i];\n"
+	"\t\t\t\ttotal += value;\n"
+	"\t\t\t}\n"
+	"\t\t\treturn total;\n"
+	"\t\t}\n"
+	"\t};\n\n")
+if(SYNTHETIC_TEMPLATE_INSTANCES GREATER 0)
+	math(EXPR LAST_INSTANCE "${SYNTHETIC_TEMPLATE_INSTANCES} - 1")
+	foreach(INSTANCE RANGE ${LAST_INSTANCE})
+		math(EXPR LENGTH "${INSTANCE} / 2 + 1")
+		math(EXPR IS_ODD "${INSTANCE} % 2")
+		if(IS_ODD)
+			string(APPEND UNIT_TEMPLATE "\ttemplate struct Buffer<double, ${LENGTH}>;\n")
+		else()
+			string(APPEND UNIT_TEMPLATE "\ttemplate struct Buffer<int32_t, ${LENGTH}>;\n")
+		endif()
+	endforeach()
+	string(APPEND UNIT_TEMPLATE "\n")
+endif()
+
+string(APPEND UNIT_TEMPLATE "\tint global_counter = @UNIT@;\n")
+
+# Functions walking a list of records. The loop over the records is the
+# outermost scope, and every scope within it declares a variable of its own.
+if(SYNTHETIC_FUNCTIONS_PER_CU GREATER 0)
+	math(EXPR LAST_FUNCTION "${SYNTHETIC_FUNCTIONS_PER_CU} - 1")
+	foreach(FUNCTION RANGE ${LAST_FUNCTION})
+		math(EXPR TYPE "${FUNCTION} % ${TYPE_COUNT}")
+		string(APPEND UNIT_TEMPLATE
+			"\n\tint32_t function_${FUNCTION}(const Record${TYPE} *first)\n"
+			"\t{\n"
+			"\t\tAccumulator accumulator(global_counter);\n")
+
+		set(INDENT "\t\t")
+		set(CLOSING "")
+		if(SYNTHETIC_SCOPE_DEPTH GREATER 0)
+			string(APPEND UNIT_TEMPLATE
+				"${INDENT}for (const Record${TYPE} *record = first; record != nullptr; record = record->next)\n"
+				"${INDENT}{\n"
+				"${INDENT}\taccumulator.add(record->id, record->weight);\n")
+			set(CLOSING "${INDENT}}\n")
+			set(INDENT "${INDENT}\t")
+			set(PREVIOUS "record->weight")
+		endif()
+		if(SYNTHETIC_SCOPE_DEPTH GREATER 1)
+			foreach(DEPTH RANGE 2 ${SYNTHETIC_SCOPE_DEPTH})
+				string(APPEND UNIT_TEMPLATE
+					"${INDENT}if (${PREVIOUS} > 1.0)\n"
+					"${INDENT}{\n"
+					"${INDENT}\tdouble excess_${DEPTH} = ${PREVIOUS} - 1.0;\n"
+					"${INDENT}\taccumulator.add(record->id, excess_${DEPTH});\n")
+				set(CLOSING "${INDENT}}\n${CLOSING}")
+				set(INDENT "${INDENT}\t")
+				set(PREVIOUS "excess_${DEPTH}")
+			endforeach()
+		endif()
+
+		string(APPEND UNIT_TEMPLATE "${CLOSING}" "\t\treturn accumulator.result();\n" "\t}\n")
+	endforeach()
+endif()
+
+string(APPEND UNIT_TEMPLATE "}\n\n"
+	"int unit_@UNIT@_entry(int seed)\n"
+	"{\n"
+	"\tunit_@UNIT@::Record0 records[2] = {\n"
+	"\t\t{seed, 1.5, \"first\", nullptr},\n"
+	"\t\t{seed + 1, 2.5, \"second\", nullptr}\n"
+	"\t};\n"
+	"\trecords[0].next = &records[1];\n")
+if(SYNTHETIC_FUNCTIONS_PER_CU GREATER 0)
+	string(APPEND UNIT_TEMPLATE "\treturn unit_@UNIT@::function_0(records);\n")
+else()
+	string(APPEND UNIT_TEMPLATE "\treturn records[0].id + unit_@UNIT@::global_counter;\n")
+endif()
+string(APPEND UNIT_TEMPLATE "}\n")
+
+file(WRITE ${OUTPUT_DIR}/unit.cpp.in "${UNIT_TEMPLATE}")
+
+math(EXPR LAST_UNIT "${SYNTHETIC_CU_COUNT} - 1")
+foreach(UNIT RANGE ${LAST_UNIT})
+	configure_file(${OUTPUT_DIR}/unit.cpp.in ${OUTPUT_DIR}/unit_${UNIT}.cpp @ONLY)
+endforeach()
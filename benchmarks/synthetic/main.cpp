@@ -0,0 +1,6 @@
+// Entry point of the synthetic executable. The generated compilation units
+// are only there to be loaded by the benchmarks, so none of them are called.
+int main()
+{
+	return 0;
+}
@@ -0,0 +1,92 @@
+// Measures the time from reading an executable's debugging information to
+// its target process stopping at the first breakpoint, for each load mode.
+//
+// Usage: time_to_first_breakpoint <executable> <source_file> <line> [repetitions]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "DebugEngine.hpp"
+#include "DebugInfo.hpp"
+
+#include "QuietStdout.hpp"
+
+struct Timings
+{
+	// Time taken to read the debugging information
+	double load;
+	// Time taken from the start of the load until the breakpoint is hit
+	double first_breakpoint;
+};
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start_time)
+{
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+	return elapsed.count();
+}
+
+// Returns the fastest of several runs, in milliseconds
+static Timings timeFirstBreakpoint(const std::string &executable, const std::string &source_file,
+                                   unsigned int line, DebugInfo::LoadMode mode,
+                                   unsigned int repetitions)
+{
+	Timings best = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+	for (unsigned int i = 0; i < repetitions; i++)
+	{
+		QuietStdout quiet;
+		auto start_time = std::chrono::steady_clock::now();
+
+		std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom(executable, mode);
+		double load = millisecondsSince(start_time);
+
+		// The engine continues the target to completion when it is destroyed
+		auto engine = std::make_shared<DebugEngine>(executable, debug_info);
+		engine->addBreakpoint(source_file.c_str(), line);
+		engine->run();
+		while (engine->tryPoll() == nullptr) {}
+		double first_breakpoint = millisecondsSince(start_time);
+
+		best.load = std::min(best.load, load);
+		best.first_breakpoint = std::min(best.first_breakpoint, first_breakpoint);
+	}
+	return best;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 4)
+	{
+		fprintf(stderr, "Usage: %s <executable> <source_file> <line> [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::string executable = argv[1];
+	std::string source_file = argv[2];
+	unsigned int line = std::max(1, atoi(argv[3]));
+	unsigned int repetitions = 3;
+	if (argc > 4)
+		repetitions = std::max(1, atoi(argv[4]));
+
+	struct
+	{
+		const char *name;
+		DebugInfo::LoadMode mode;
+	} modes[] = {
+		{"indexed", DebugInfo::LOAD_INDEXED},
+		{"lazy", DebugInfo::LOAD_LAZY},
+		{"background", DebugInfo::LOAD_BACKGROUND}
+	};
+
+	printf("%-10s %12s %22s\n", "mode", "load (ms)", "first breakpoint (ms)");
+	for (const auto &mode : modes)
+	{
+		Timings timings = timeFirstBreakpoint(executable, source_file, line, mode.mode, repetitions);
+		printf("%-10s %12.1f %22.1f\n", mode.name, timings.load, timings.first_breakpoint);
+	}
+	return 0;
+}
@@ -4,6 +4,7 @@
 CC=clang
 CXX=clang++
 BUILDTESTS=OFF
+BUILDBENCHMARKS=OFF
 
 # Get all options
 for i in "$@"
@@ -21,6 +22,10 @@ case $i in
     BUILDTESTS=ON
     shift # past argument with no value
     ;;
+    --build-benchmarks)
+    BUILDBENCHMARKS=ON
+    shift # past argument with no value
+    ;;
     *)
           # unknown option
     ;;
@@ -29,6 +34,7 @@ done
 echo "CC COMPILER  = ${CC}"
 echo "CXX COMPILER = ${CXX}"
 echo "BUILD TESTS  = ${BUILDTESTS}"
+echo "BUILD BENCHMARKS = ${BUILDBENCHMARKS}"
 
 # The directory location of this script
 DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" >/dev/null && pwd )"
@@ -38,6 +44,6 @@ mkdir -p $DIR/build
 cd $DIR/build
 
 # Build with the specified options
-cmake -DBUILD_TESTS=$BUILDTESTS -DCMAKE_C_COMPILER=$CC -DCMAKE_CXX_COMPILER=$CXX ..
+cmake -DBUILD_TESTS=$BUILDTESTS -DBUILD_BENCHMARKS=$BUILDBENCHMARKS -DCMAKE_C_COMPILER=$CC -DCMAKE_CXX_COMPILER=$CXX ..
 CORES=`grep -c ^processor /proc/cpuinfo`
 make -j$CORES
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "AddressSpace.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include <elf.h>
+
+#include "ELFFile.hpp"
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+const AddressSpace::Module *AddressSpace::add(const std::string &path, uint64_t load_bias,
+                                              std::shared_ptr<DebugInfo> debug_info)
+{
+	Module module;
+	module.path = path;
+	module.load_bias = load_bias;
+	module.start_address = std::numeric_limits<uint64_t>::max();
+	module.end_address = 0;
+	module.debug_info = debug_info;
+
+	for (const auto &segment : debug_info->getELFFile()->segments())
+	{
+		if (segment.type != PT_LOAD)
+			continue;
+		module.start_address = std::min(module.start_address, load_bias + segment.virtual_address);
+		module.end_address = std::max(module.end_address,
+		                              load_bias + segment.virtual_address + segment.memory_size);
+	}
+	if (module.start_address >= module.end_address)
+	{
+		procmsg("[ADDRESS_SPACE] %s has no loadable segments!\n", path.c_str());
+		return nullptr;
+	}
+
+	procmsg("[ADDRESS_SPACE] %s loaded at 0x%lx-0x%lx\n", path.c_str(), module.start_address, module.end_address);
+	Module &added = modules_by_address[module.start_address];
+	added = std::move(module);
+	return &added;
+}
+
+void AddressSpace::remove(const std::string &path, uint64_t load_bias)
+{
+	for (auto it = modules_by_address.begin(); it != modules_by_address.end(); ++it)
+	{
+		if (it->second.path == path && it->second.load_bias == load_bias)
+		{
+			modules_by_address.erase(it);
+			return;
+		}
+	}
+}
+
+const AddressSpace::Module *AddressSpace::find(uint64_t address) const
+{
+	// The module starting at or before the address is the only one which can
+	// contain it, as modules don't overlap
+	auto it = modules_by_address.upper_bound(address);
+	if (it == modules_by_address.begin())
+		return nullptr;
+	--it;
+	return (address < it->second.end_address) ? &it->second : nullptr;
+}
+
+const AddressSpace::Module *AddressSpace::find(const std::string &path, uint64_t load_bias) const
+{
+	for (const auto &entry : modules_by_address)
+	{
+		if (entry.second.path == path && entry.second.load_bias == load_bias)
+			return &entry.second;
+	}
+	return nullptr;
+}
+
+const std::map<uint64_t, AddressSpace::Module> &AddressSpace::modules() const
+{
+	return modules_by_address;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "DebugInfo.hpp"
+
+// The executable and shared objects loaded into the target process which have
+// debugging information, ordered by the addresses they were loaded at so that
+// the object an address belongs to is found by a binary search.
+class AddressSpace
+{
+public:
+	struct Module
+	{
+		std::string path;
+		// Added to the addresses in the object's debugging information to get
+		// the addresses it was loaded at
+		uint64_t load_bias;
+		uint64_t start_address;
+		uint64_t end_address;
+		std::shared_ptr<DebugInfo> debug_info;
+
+		// Converts between addresses in the process and in the object
+		uint64_t toObjectAddress(uint64_t address) const
+		{
+			return address - load_bias;
+		}
+
+		uint64_t toLoadedAddress(uint64_t address) const
+		{
+			return address + load_bias;
+		}
+	};
+
+	// The range of the module is that of the segments loaded from its file.
+	// Returns the module added, or null if the file loads no segments.
+	const Module *add(const std::string &path, uint64_t load_bias, std::shared_ptr<DebugInfo> debug_info);
+	void remove(const std::string &path, uint64_t load_bias);
+
+	// Gets the module an address was loaded from, or null if it is in none
+	const Module *find(uint64_t address) const;
+	const Module *find(const std::string &path, uint64_t load_bias) const;
+
+	const std::map<uint64_t, Module> &modules() const;
+
+private:
+	// Keyed by start address
+	std::map<uint64_t, Module> modules_by_address;
+};
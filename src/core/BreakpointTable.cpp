@@ -1,7 +1,16 @@
 #include "BreakpointTable.hpp"
 
+#include <algorithm>
 #include <cstring>
 
+#include <unistd.h>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+// Breakpoints further apart than this many bytes are patched separately
+static const uint64_t MAX_RUN_GAP = 64;
+
 BreakpointTable::BreakpointTable()
 {
 	
@@ -35,6 +44,69 @@ void BreakpointTable::enableBreakpoints(ProcessTracer& tracer)
 	mtx.unlock();
 }
 
+void BreakpointTable::enableBreakpoints(ProcessTracer& tracer, const std::vector<uint64_t>& addresses)
+{
+	if (addresses.empty())
+		return;
+
+	// Breakpoints close together within a page are patched as one run, so the
+	// code between distant ones isn't rewritten. The original word at each
+	// breakpoint is kept, as when enabling them one at a time, so a run
+	// extends a word past the last of them.
+	std::vector<uint64_t> sorted_addresses = addresses;
+	std::sort(sorted_addresses.begin(), sorted_addresses.end());
+	sorted_addresses.erase(std::unique(sorted_addresses.begin(), sorted_addresses.end()),
+	                       sorted_addresses.end());
+
+	const uint64_t page_size = sysconf(_SC_PAGESIZE);
+	std::vector<Run> runs;
+	for (uint64_t address : sorted_addresses)
+	{
+		bool is_in_run = !runs.empty() &&
+		                 address <= runs.back().end_address + MAX_RUN_GAP &&
+		                 address / page_size == runs.back().start_address / page_size;
+		if (!is_in_run)
+			runs.push_back(Run{address, address, {}, {}});
+		runs.back().end_address = address + sizeof(uint64_t);
+		runs.back().addresses.push_back(address);
+	}
+
+	// The runs are all read together
+	std::vector<ProcessTracer::MemoryRegion> regions;
+	regions.reserve(runs.size());
+	for (auto &run : runs)
+	{
+		run.code.resize(run.end_address - run.start_address);
+		regions.push_back({run.start_address, run.code.data(), run.code.size()});
+	}
+	if (!tracer.readMemory(regions).has_value())
+	{
+		mtx.lock();
+		for (uint64_t address : sorted_addresses)
+			breakpoints_by_address.at(address).enable(tracer);
+		mtx.unlock();
+		return;
+	}
+
+	for (auto &run : runs)
+	{
+		mtx.lock();
+		std::vector<uint8_t> patched_code = run.code;
+		for (uint64_t address : run.addresses)
+		{
+			Breakpoint &breakpoint = breakpoints_by_address.at(address);
+			size_t offset = address - run.start_address;
+			memcpy(&breakpoint.orig_data, run.code.data() + offset, sizeof(breakpoint.orig_data));
+			patched_code[offset] = 0xCC;
+		}
+		mtx.unlock();
+
+		auto result = tracer.writeMemory(run.start_address, patched_code.data(), patched_code.size());
+		if (!result.has_value())
+			procmsg("[BREAKPOINT_TABLE] %s: 0x%lx\n", result.error().c_str(), run.start_address);
+	}
+}
+
 void BreakpointTable::disableBreakpoints(ProcessTracer& tracer)
 {
 	mtx.lock();
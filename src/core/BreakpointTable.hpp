@@ -22,11 +22,25 @@ public:
 	Breakpoint &getBreakpoint(uint64_t address);
 
 	void enableBreakpoints(ProcessTracer& tracer);
+	// Enables a group of breakpoints, such as those in a newly loaded object.
+	// Their code is read in a single call, and breakpoints close together are
+	// patched with a single write.
+	void enableBreakpoints(ProcessTracer& tracer, const std::vector<uint64_t>& addresses);
 	void disableBreakpoints(ProcessTracer& tracer);
 
 	bool isBreakpoint(uint64_t address);
 
 private:
+	// Breakpoints close enough together to be patched with one write, along
+	// with the code they cover
+	struct Run
+	{
+		uint64_t start_address;
+		uint64_t end_address;
+		std::vector<uint64_t> addresses;
+		std::vector<uint8_t> code;
+	};
+
 	std::mutex mtx;
 	std::unordered_map<uint64_t, Breakpoint> breakpoints_by_address;
 };
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "DebugEngine.hpp"
 
-DebugEngine::DebugEngine(const std::string& executable_name, std::shared_ptr<DebugInfo> debug_info) :
+DebugEngine::DebugEngine(const std::string& executable_name, std::shared_ptr<DebugInfo> debug_info,
+                         std::shared_ptr<ThreadSafeQueue<IndexProgressMessage>> index_progress) :
 	target_name(executable_name),
-	debug_info(debug_info)
+	debug_info(debug_info),
+	index_progress(index_progress)
 {
-
+	if (this->index_progress == nullptr)
+		this->index_progress = std::make_shared<ThreadSafeQueue<IndexProgressMessage>>();
 }
 
 DebugEngine::~DebugEngine()
@@ -37,6 +40,20 @@ bool DebugEngine::addBreakpoint(const char* source_file, unsigned int line_numbe
 	}
 }
 
+bool DebugEngine::addFunctionBreakpoint(const char* function_name)
+{
+	auto function = debug_info->getFunctionByName(function_name);
+	if (!function)
+		return false;
+
+	auto line = debug_info->getLine(function.value().start_address);
+	if (!line)
+		return false;
+
+	const std::string &source_file = debug_info->getSourcePath(line.value().file);
+	return addBreakpoint(source_file.c_str(), line.value().number);
+}
+
 bool DebugEngine::removeBreakpoint(const char* source_file, unsigned int line_number)
 {
 	BreakpointLine line;
@@ -94,9 +111,17 @@ void DebugEngine::sendMessage(std::unique_ptr<DebugMessage> msg)
 
 std::unique_ptr<DebugMessage> DebugEngine::tryPoll()
 {
+	if (debugger == nullptr)
+		return nullptr;
 	return std::move(debugger->tryPoll());
 }
 
+std::unique_ptr<IndexProgressMessage> DebugEngine::tryPollIndexProgress()
+{
+	// Progress can arrive before there is a target process
+	return index_progress->tryPop();
+}
+
 bool DebugEngine::isDebugging()
 {
 	return debugger != nullptr && debugger->isDebugging();
@@ -12,6 +12,14 @@
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
 
+// Sent while the debug information is indexed in the background
+class IndexProgressMessage : public DebugMessage
+{
+public:
+	size_t indexed_units;
+	size_t total_units;
+};
+
 // Contains all of the tools needed to debug a process.
 // Contains resources which can be used both in and outside of the debugging
 // of a target process, such as setting breakpoints in preparation for
@@ -19,12 +27,20 @@ void procmsg(const char* format, ...);
 class DebugEngine
 {
 public:
-	DebugEngine(const std::string& executable_name, std::shared_ptr<DebugInfo> debug_info);
+	// The progress of indexing the debug information is posted to the given
+	// queue by whatever indexes it, and is polled apart from the messages
+	// about the target process
+	DebugEngine(const std::string& executable_name, std::shared_ptr<DebugInfo> debug_info,
+	            std::shared_ptr<ThreadSafeQueue<IndexProgressMessage>> index_progress = nullptr);
 	~DebugEngine();
 
 	bool run();
 
 	bool addBreakpoint(const char* source_file, unsigned int line_number);
+	// Adds a breakpoint on the first line of a function, which may be
+	// qualified ("ns::Class::method"). Fails if the executable doesn't define
+	// the function.
+	bool addFunctionBreakpoint(const char* function_name);
 	bool removeBreakpoint(const char* source_file, unsigned int line_number);
 	bool isBreakpoint(const char* source_file, unsigned int line_number);
 
@@ -35,6 +51,7 @@ public:
 
 	void sendMessage(std::unique_ptr<DebugMessage> msg);
 	std::unique_ptr<DebugMessage> tryPoll();
+	std::unique_ptr<IndexProgressMessage> tryPollIndexProgress();
 
 	bool isDebugging();
 
@@ -44,4 +61,5 @@ private:
 	std::shared_ptr<ProcessDebugger> debugger = nullptr;
 	std::shared_ptr<DebugInfo> debug_info = nullptr;
 	std::vector<BreakpointLine> breakpoint_lines;
+	std::shared_ptr<ThreadSafeQueue<IndexProgressMessage>> index_progress = nullptr;
 };
\ No newline at end of file
@@ -1,14 +1,54 @@
 #include "DebugInfo.hpp"
 
 #include <cassert>
+#include <map>
+#include <mutex>
 
+#include <unistd.h>
+
+#include "dwarf/DebugFileLocator.hpp"
 #include "dwarf/DwarfDebug.hpp"
 #include "dwarf/DwarfExprInterpreter.hpp"
 #include "dwarf/ValueDeducer.hpp"
 
-std::shared_ptr<DebugInfo> DebugInfo::readFrom(const std::string &executable_name)
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+std::shared_ptr<DebugInfo> DebugInfo::readFrom(const std::string &executable_name, LoadMode mode,
+                                               const std::string &cache_directory,
+                                               IndexProgressHandler progress)
 {
-	return std::make_shared<DwarfDebugInfo>(executable_name);
+	return std::make_shared<DwarfDebugInfo>(executable_name, mode, cache_directory, progress);
+}
+
+std::shared_ptr<DebugInfo> DebugInfo::readShared(const std::string &object_name, LoadMode mode)
+{
+	// Objects are shared for as long as anything uses them, so one loaded by
+	// many processes, or loaded again after being unloaded, is only read once
+	static std::mutex mtx;
+	static std::map<std::string, std::weak_ptr<DebugInfo>> shared_objects;
+
+	std::lock_guard<std::mutex> lock(mtx);
+	std::shared_ptr<DebugInfo> debug_info = shared_objects[object_name].lock();
+	if (debug_info != nullptr)
+		return debug_info;
+
+	// Objects like the vDSO have no file
+	if (access(object_name.c_str(), R_OK) != 0)
+		return nullptr;
+	auto expected_elf_file = ELFFile::open(object_name);
+	if (!expected_elf_file)
+	{
+		procmsg("[DWARF_ERROR] %s\n", expected_elf_file.error().c_str());
+		return nullptr;
+	}
+	std::shared_ptr<ELFFile> elf_file = expected_elf_file.value();
+	if (!DebugFileLocator::hasDebugInfo(*DebugFileLocator().locate(elf_file)))
+		return nullptr;
+
+	debug_info = std::make_shared<DwarfDebugInfo>(elf_file, mode);
+	shared_objects[object_name] = debug_info;
+	return debug_info;
 }
 
 std::string DebugInfo::toAbsolutePath(const std::string &dir, const std::string &name)
@@ -23,28 +63,75 @@ std::string DebugInfo::toAbsolutePath(const std::string &dir, const std::string
 		return name;
 }
 
-DwarfDebugInfo::DwarfDebugInfo(const std::string &executable_name) :
-	dwarf(std::make_shared<DwarfDebug>(executable_name))
+static DwarfLoadOptions loadOptions(DebugInfo::LoadMode mode, const std::string &cache_directory,
+                                    DebugInfo::IndexProgressHandler progress)
 {
+	DwarfLoadOptions options;
+	options.flatten_dies = (mode == DebugInfo::LOAD_FLATTENED);
+	options.lazy = (mode == DebugInfo::LOAD_LAZY);
+	options.background = (mode == DebugInfo::LOAD_BACKGROUND);
+	options.cache_directory = cache_directory;
+	options.progress = progress;
+	return options;
+}
 
+DwarfDebugInfo::DwarfDebugInfo(const std::string &executable_name, LoadMode mode,
+                               const std::string &cache_directory, IndexProgressHandler progress)
+{
+	dwarf = std::make_shared<DwarfDebug>(executable_name, loadOptions(mode, cache_directory, progress));
 }
 
-DwarfDebugInfo::Variable DwarfDebugInfo::getVariable(const std::string &variable_name, pid_t pid) const
+DwarfDebugInfo::DwarfDebugInfo(std::shared_ptr<ELFFile> elf_file, LoadMode mode,
+                               const std::string &cache_directory, IndexProgressHandler progress)
+{
+	dwarf = std::make_shared<DwarfDebug>(elf_file, loadOptions(mode, cache_directory, progress));
+}
+
+DwarfDebugInfo::Variable DwarfDebugInfo::getVariable(const std::string &variable_name, ProcessTracer &tracer,
+                                                     uint64_t pc, uint64_t load_bias) const
 {
 	DwarfDebugInfo::Variable var;
 	var.name = variable_name;
 
-	auto loc_expr_opt = dwarf->info()->getVarLocExpr(variable_name, pid);
+	expected<ScopeIndex::VariableLocExpr, std::string> loc_expr_opt =
+		make_unexpected("Could not determine location expression: " + variable_name);
+	DwarfDebug::Indices unit = dwarf->indices(pc);
+	if (unit.scopes != nullptr)
+		loc_expr_opt = unit.scopes->getVarLocExpr(variable_name, pc);
+
+	// Globals may be declared in compilation units other than the one
+	// containing the PC, which aren't in the same index when loading lazily
+	// or when they were split into .dwo files
+	if (!loc_expr_opt.has_value())
+	{
+		for (const auto &global_unit : dwarf->globalIndices(variable_name))
+		{
+			loc_expr_opt = global_unit.scopes->getGlobalVarLocExpr(variable_name);
+			if (loc_expr_opt.has_value())
+			{
+				unit = global_unit;
+				break;
+			}
+		}
+	}
+
 	if (loc_expr_opt.has_value())
 	{
-		DwarfExprInterpreter interpreter(pid);
+		// The frame base is found by libunwind, which reads the registers
+		// itself
+		tracer.flushRegisters();
+		DwarfExprInterpreter interpreter(tracer.traceePID());
 		uint64_t address = interpreter.parse(&loc_expr_opt.value().frame_base,
 		                                     loc_expr_opt.value().location_op,
 		                                     loc_expr_opt.value().location_param);
-		if (address > 0)
+		// Only a static address is relative to where the object was linked
+		if (address > 0 && loc_expr_opt.value().location_op == DW_OP_addr)
+			address += load_bias;
+		std::unique_ptr<DIE> type = unit.info->getDIEByOffset(loc_expr_opt.value().type_offset);
+		if (address > 0 && type != nullptr)
 		{
-			ValueDeducer deducer(pid, dwarf);
-			var.value = deducer.deduce(address, *(loc_expr_opt.value().type));
+			ValueDeducer deducer(tracer, unit.info);
+			var.value = deducer.deduce(address, *type);
 		}
 		else
 		{
@@ -60,85 +147,83 @@ DwarfDebugInfo::Variable DwarfDebugInfo::getVariable(const std::string &variable
 
 expected<DwarfDebugInfo::Function, std::string> DwarfDebugInfo::getFunction(uint64_t address) const
 {
-	DIEMatcher matcher;
-	matcher.setTags({"DW_TAG_subprogram"});
-	std::vector<DIE> subprograms = dwarf->info()->getDIEs(matcher);
-	for (auto sub : subprograms)
-	{
-		auto expected_low_pc = sub.getAttributeValue<DW_AT_low_pc>();
-		auto expected_high_pc = sub.getAttributeValue<DW_AT_high_pc>();
-
-		// Subprogram DIEs may not have lowpc/highpc address values.
-		// This occurs when they are externally defined from the CU.
-		if (!expected_low_pc || !expected_high_pc)
-			continue;
+	std::shared_ptr<FunctionIndex> functions = dwarf->functions(address);
+	const FunctionEntry *entry = (functions != nullptr) ? functions->find(address) : nullptr;
+	if (entry == nullptr)
+		return make_unexpected("Failed to find function at address: " + std::to_string(address));
+
+	const CompileUnitEntry &cu = functions->getCompileUnit(entry->compile_unit);
+
+	DebugInfo::Function function;
+	function.name = entry->name;
+	function.start_address = entry->start_address;
+	function.end_address = entry->end_address;
+	function.decl_file = toAbsolutePath(cu.comp_dir, cu.name);
+	function.decl_line = entry->decl_line;
+	return function;
+}
 
-		uint64_t low_pc = expected_low_pc.value();
-		uint64_t high_pc = expected_high_pc.value();
-		if (address >= low_pc && address < (low_pc + high_pc))
+expected<DwarfDebugInfo::Function, std::string> DwarfDebugInfo::getFunctionByName(const std::string &name) const
+{
+	// Declarations have no address ranges, so the definition is the DIE
+	// which does
+	for (const auto &reader : dwarf->readers(name))
+	{
+		for (Dwarf_Off offset : reader->findDIEsByName(name))
 		{
-			DebugInfo::Function function;
-			function.name = sub.getAttributeValue<DW_AT_name>().value();
-			function.start_address = sub.getAttributeValue<DW_AT_low_pc>().value();
-			function.end_address = sub.getAttributeValue<DW_AT_low_pc>().value() + sub.getAttributeValue<DW_AT_high_pc>().value();
-
-			Dwarf_Off cu_offset = sub.getCUOffset();
-			DIE cu = *(dwarf->info()->getDIEByOffset(cu_offset));
-			std::string file_name = cu.getAttributeValue<DW_AT_name>().value();
-			std::string file_dir = cu.getAttributeValue<DW_AT_comp_dir>().value();
-			function.decl_file = toAbsolutePath(file_dir, file_name);
-			function.decl_line = sub.getAttributeValue<DW_AT_decl_line>().value();
-
-			return function;
+			std::unique_ptr<DIE> die = reader->getDIEByOffset(offset);
+			if (die == nullptr || die->getTag() != DW_TAG_subprogram)
+				continue;
+
+			for (const auto &pc_range : die->getPCRanges())
+			{
+				if (pc_range.low_pc != 0)
+					return getFunction(pc_range.low_pc);
+			}
 		}
 	}
-	return make_unexpected("Failed to find function at address: " + std::to_string(address));
+	return make_unexpected("Failed to find function: " + name);
 }
 
-// std::optional<DwarfDebugInfo::SourceLine> DwarfDebugInfo::getLine(uint64_t address) const
-// {
-// 	std::optional<Line> line = dwarf->line()->getLine(address);
-// 	if (line.has_value())
-// 	{
-// 		Line val = line.value();
-// 		return std::optional<DwarfDebugInfo::SourceLine>({val.number, val.address, val.source});
-// 	}
-// 	else
-// 	{
-// 		return std::nullopt;
-// 	}
-// }
+expected<DwarfDebugInfo::SourceLine, std::string> DwarfDebugInfo::getLine(uint64_t address) const
+{
+	return dwarf->line()->getLine(address);
+}
 
-std::vector<DwarfDebugInfo::SourceLine> DwarfDebugInfo::getFunctionLines(uint64_t address) const
+DwarfDebugInfo::SourceLines DwarfDebugInfo::getFunctionLines(uint64_t address) const
 {
-	std::vector<Line> dwarf_lines = dwarf->line()->getFunctionLines(address);
-	std::vector<DwarfDebugInfo::SourceLine> lines;
-	for (const auto &line : dwarf_lines)
-		lines.push_back({line.number, line.address, line.source});
-	return lines;
+	std::shared_ptr<FunctionIndex> functions = dwarf->functions(address);
+	const FunctionEntry *function = (functions != nullptr) ? functions->find(address) : nullptr;
+	if (function == nullptr)
+		return {};
+
+	return dwarf->line()->getAddressRangeLines(function->start_address, function->end_address);
 }
 
-std::vector<DwarfDebugInfo::SourceLine> DwarfDebugInfo::getSourceFileLines(const std::string &file_name) const
+DwarfDebugInfo::SourceLines DwarfDebugInfo::getSourceFileLines(const std::string &file_name) const
 {
 	std::vector<DIE> compile_units = dwarf->info()->getCompileUnits();
 	for (const auto &cu : compile_units)
 	{
-		std::string name = cu.getAttributeValue<DW_AT_name>().value();
-		std::string dir = cu.getAttributeValue<DW_AT_comp_dir>().value();
-		std::string path = toAbsolutePath(dir, name);
+		SourceFile file = dwarf->sourceFile(cu);
+		std::string path = toAbsolutePath(file.dir, file.name);
 
 		if (file_name == path)
-		{
-			std::vector<Line> dwarf_lines = dwarf->line()->getCULines(cu);
-			std::vector<DwarfDebugInfo::SourceLine> lines;
-			for (const auto &line : dwarf_lines)
-				lines.push_back({line.number, line.address, line.source});
-			return lines;
-		}
+			return dwarf->line()->getCULines(cu);
 	}
 	return {};
 }
 
+const std::string &DwarfDebugInfo::getSourcePath(uint32_t file) const
+{
+	return dwarf->paths()->path(file);
+}
+
+expected<uint32_t, std::string> DwarfDebugInfo::getSourcePathId(const std::string &path) const
+{
+	return dwarf->paths()->find(path);
+}
+
 std::vector<std::string> DwarfDebugInfo::getSourceFiles() const
 {
 	std::vector<std::string> file_names;
@@ -149,4 +234,14 @@ std::vector<std::string> DwarfDebugInfo::getSourceFiles() const
 		file_names.push_back(toAbsolutePath(file.dir, file.name));
 	}
 	return file_names;
-}
\ No newline at end of file
+}
+
+std::shared_ptr<ELFFile> DwarfDebugInfo::getELFFile() const
+{
+	return dwarf->elf();
+}
+
+void DwarfDebugInfo::waitUntilIndexed() const
+{
+	dwarf->waitUntilIndexed();
+}
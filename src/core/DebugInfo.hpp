@@ -1,6 +1,7 @@
 #ifndef _DEBUG_INFO_H_
 #define _DEBUG_INFO_H_
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -8,9 +9,13 @@
 #include <sys/types.h>
 
 #include "expected.hpp"
+#include "SourcePaths.hpp"
+#include "Span.hpp"
 using namespace nonstd;
 
 class DwarfDebug;
+class ELFFile;
+class ProcessTracer;
 
 /*
 This is a unified and simplified interface for retrieving information about
@@ -37,21 +42,68 @@ public:
 		std::string value;
 	};
 
-	struct SourceLine
+	// Lines refer to their source file by an ID, which getSourcePath() turns
+	// back into a path. Lists of lines are views of the cached line tables,
+	// and stay valid for as long as the debug information does.
+	using SourceLine = ::SourceLine;
+	using SourceLines = Span<SourceLine>;
+
+	// How much of the debugging information is processed when it is read:
+	// - LOAD_INDEXED builds the function and scope indices up front.
+	// - LOAD_FLATTENED also decodes every DIE, which takes longer and uses
+	//   more memory, but makes later queries cheaper.
+	// - LOAD_LAZY only reads the compilation units' headers, and indexes each
+	//   unit the first time it is queried, for the fastest startup.
+	// - LOAD_BACKGROUND starts up like LOAD_LAZY, then builds the indices on
+	//   background threads. Queries made before they are ready only wait for
+	//   the compilation unit they need.
+	enum LoadMode
 	{
-		uint64_t number;
-		uint64_t address;
-		std::string file_name;
+		LOAD_INDEXED,
+		LOAD_FLATTENED,
+		LOAD_LAZY,
+		LOAD_BACKGROUND
 	};
 
-	static std::shared_ptr<DebugInfo> readFrom(const std::string &executable_name);
+	// Called with the number of compilation units indexed so far and the
+	// total, possibly from another thread. The last call, once the indices
+	// are ready, has both equal.
+	using IndexProgressHandler = std::function<void(size_t indexed_units, size_t total_units)>;
+
+	// If a cache directory is given, the indices are saved there and reused by
+	// later reads of the same executable
+	static std::shared_ptr<DebugInfo> readFrom(const std::string &executable_name,
+	                                           LoadMode mode = LOAD_INDEXED,
+	                                           const std::string &cache_directory = "",
+	                                           IndexProgressHandler progress = nullptr);
+
+	// Reads the debugging information of a shared object, or shares that
+	// already read from it. Returns null if the object has none, as is usual
+	// for system libraries.
+	static std::shared_ptr<DebugInfo> readShared(const std::string &object_name, LoadMode mode = LOAD_LAZY);
 
-	virtual Variable getVariable(const std::string &variable_name, pid_t pid) const = 0;
+	// Gets the value of the variable visible from the specified PC. The PC is
+	// an address in the object, which was loaded with the given bias. The
+	// addresses of globals are moved by the bias, while those found from the
+	// tracee's registers already refer to where it was loaded. The tracee's
+	// memory is read through the tracer.
+	virtual Variable getVariable(const std::string &variable_name, ProcessTracer &tracer, uint64_t pc,
+	                             uint64_t load_bias = 0) const = 0;
 	virtual expected<Function, std::string> getFunction(uint64_t address) const = 0;
-	// virtual std::optional<SourceLine> getLine(uint64_t address) const = 0;
-	virtual std::vector<SourceLine> getFunctionLines(uint64_t address) const = 0;
-	virtual std::vector<SourceLine> getSourceFileLines(const std::string &file_name) const = 0;
+	// Finds a function defined with a name, which may be qualified by its
+	// namespaces ("ns::function")
+	virtual expected<Function, std::string> getFunctionByName(const std::string &name) const = 0;
+	virtual expected<SourceLine, std::string> getLine(uint64_t address) const = 0;
+	virtual SourceLines getFunctionLines(uint64_t address) const = 0;
+	virtual SourceLines getSourceFileLines(const std::string &file_name) const = 0;
+	virtual const std::string &getSourcePath(uint32_t file) const = 0;
+	virtual expected<uint32_t, std::string> getSourcePathId(const std::string &path) const = 0;
 	virtual std::vector<std::string> getSourceFiles() const = 0;
+	// The mapping of the executable the information was read from, which can
+	// be shared rather than mapping the executable again
+	virtual std::shared_ptr<ELFFile> getELFFile() const = 0;
+	// Blocks until any indexing in the background has finished
+	virtual void waitUntilIndexed() const = 0;
 
 	static std::string toAbsolutePath(const std::string &dir, const std::string &file);
 };
@@ -59,14 +111,23 @@ public:
 class DwarfDebugInfo : public DebugInfo
 {
 public:
-	DwarfDebugInfo(const std::string &executable_name);
+	DwarfDebugInfo(const std::string &executable_name, LoadMode mode = LOAD_INDEXED,
+	               const std::string &cache_directory = "", IndexProgressHandler progress = nullptr);
+	DwarfDebugInfo(std::shared_ptr<ELFFile> elf_file, LoadMode mode = LOAD_INDEXED,
+	               const std::string &cache_directory = "", IndexProgressHandler progress = nullptr);
 
-	virtual Variable getVariable(const std::string &variable_name, pid_t pid) const override;
+	virtual Variable getVariable(const std::string &variable_name, ProcessTracer &tracer, uint64_t pc,
+	                             uint64_t load_bias = 0) const override;
 	virtual expected<Function, std::string> getFunction(uint64_t address) const override;
-	// virtual std::optional<SourceLine> getLine(uint64_t address) const override;
-	virtual std::vector<SourceLine> getFunctionLines(uint64_t address) const override;
-	virtual std::vector<SourceLine> getSourceFileLines(const std::string &file_name) const override;
+	virtual expected<Function, std::string> getFunctionByName(const std::string &name) const override;
+	virtual expected<SourceLine, std::string> getLine(uint64_t address) const override;
+	virtual SourceLines getFunctionLines(uint64_t address) const override;
+	virtual SourceLines getSourceFileLines(const std::string &file_name) const override;
+	virtual const std::string &getSourcePath(uint32_t file) const override;
+	virtual expected<uint32_t, std::string> getSourcePathId(const std::string &path) const override;
 	virtual std::vector<std::string> getSourceFiles() const override;
+	virtual std::shared_ptr<ELFFile> getELFFile() const override;
+	virtual void waitUntilIndexed() const override;
 
 private:
 	std::shared_ptr<DwarfDebug> dwarf = nullptr;
@@ -4,14 +4,101 @@
 #include <gelf.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <cassert>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <endian.h>
+#include <cerrno>
+#include <cstring>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+ELFFile::ELFFile() :
+	mapping(nullptr),
+	mapping_size(0),
+	elf(nullptr),
+	entry_point(0),
+	type(ET_NONE),
+	is_64_bit(false),
+	is_little_endian(false)
+{
+}
 
 ELFFile::ELFFile(std::string path) :
-	file_path(std::move(path))
+	ELFFile()
 {
-	type = getType();
-	entry_point = getEntryPoint();
-	populateSectionAddresses();
+	// A file which can't be read is left without any contents
+	file_path = std::move(path);
+	auto loaded = load();
+	if (!loaded.has_value())
+		procmsg("[ELF_ERROR] %s\n", loaded.error().c_str());
+}
+
+ELFFile::~ELFFile()
+{
+	if (elf != nullptr)
+		elf_end(elf);
+	if (mapping != nullptr)
+		munmap(mapping, mapping_size);
+}
+
+expected<std::shared_ptr<ELFFile>, std::string> ELFFile::open(const std::string& file_path)
+{
+	std::shared_ptr<ELFFile> elf_file(new ELFFile());
+	elf_file->file_path = file_path;
+	auto loaded = elf_file->load();
+	if (!loaded.has_value())
+		return make_unexpected(loaded.error());
+	return elf_file;
+}
+
+expected<void, std::string> ELFFile::load()
+{
+	if (elf_version(EV_CURRENT) == EV_NONE)
+		return make_unexpected("Failed to initialise libelf: " + std::string(elf_errmsg(-1)));
+
+	int fd = ::open(file_path.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return make_unexpected("Failed to open " + file_path + ": " + strerror(errno));
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return make_unexpected("Failed to read the size of " + file_path);
+	}
+
+	void* address = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+		return make_unexpected("Failed to map " + file_path + ": " + strerror(errno));
+	mapping = static_cast<uint8_t*>(address);
+	mapping_size = st.st_size;
+
+	// libelf only writes to the image to convert the byte order of files
+	// which don't match the host's, so those are rejected before it sees the
+	// read-only mapping
+	if (mapping_size < EI_NIDENT || memcmp(mapping, ELFMAG, SELFMAG) != 0)
+		return make_unexpected("Not an ELF file: " + file_path);
+	unsigned char host_data = (__BYTE_ORDER == __LITTLE_ENDIAN) ? ELFDATA2LSB : ELFDATA2MSB;
+	if (mapping[EI_DATA] != host_data)
+		return make_unexpected("ELF file has a different byte order to the host: " + file_path);
+
+	elf = elf_memory(reinterpret_cast<char*>(mapping), mapping_size);
+	if (elf == NULL || elf_kind(elf) != ELF_K_ELF)
+		return make_unexpected("Not an ELF file: " + file_path);
+
+	GElf_Ehdr elf_header;
+	if (gelf_getehdr(elf, &elf_header) == NULL)
+		return make_unexpected("Failed to read the ELF header of " + file_path);
+	entry_point = elf_header.e_entry;
+	type = elf_header.e_type;
+	is_64_bit = (gelf_getclass(elf) == ELFCLASS64);
+	is_little_endian = (elf_header.e_ident[EI_DATA] == ELFDATA2LSB);
+
+	readSections();
+	readSegments();
+	return {};
 }
 
 std::string ELFFile::filePath() const
@@ -29,13 +116,22 @@ bool ELFFile::hasPositionIndependentCode() const
 	return type == ET_DYN;
 }
 
+bool ELFFile::is64Bit() const
+{
+	return is_64_bit;
+}
+
+bool ELFFile::isLittleEndian() const
+{
+	return is_little_endian;
+}
+
 expected<uint64_t, std::string> ELFFile::sectionAddress(const std::string& section_name) const
 {
-	auto it = section_addresses.find(section_name);
-	bool found = (it != std::end(section_addresses));
-	if (found)
+	const Section* section = findSection(section_name);
+	if (section != nullptr)
 	{
-		return it->second;
+		return section->address;
 	}
 	else
 	{
@@ -44,100 +140,159 @@ expected<uint64_t, std::string> ELFFile::sectionAddress(const std::string& secti
 	}
 }
 
-uint64_t ELFFile::getEntryPoint()
+expected<ByteSpan, std::string> ELFFile::sectionData(const std::string& section_name) const
 {
-	// Ensure the ELF library initialization doesn't fail
-	assert(elf_version(EV_CURRENT) != EV_NONE);
+	const Section* section = findSection(section_name);
+	if (section == nullptr)
+		return make_unexpected("Section " + section_name + " not found in ELF file: " + file_path);
+	return section->data;
+}
 
-	// Ensure the executable file can be read successfully
-	int fd = open(file_path.c_str(), O_RDONLY, 0);
-	assert(fd >= 0);
+expected<std::string, std::string> ELFFile::buildId() const
+{
+	if (build_id.empty())
+		return make_unexpected("No build ID found in ELF file: " + file_path);
+	return build_id;
+}
 
-	Elf* elf = elf_begin(fd, ELF_C_READ, NULL);
-	assert(elf != NULL);
+const std::vector<ELFFile::Section>& ELFFile::sections() const
+{
+	return section_list;
+}
 
-	// Ensure the executable is an ELF object
-	assert(elf_kind(elf) == ELF_K_ELF);
+const std::vector<ELFFile::Segment>& ELFFile::segments() const
+{
+	return segment_list;
+}
 
-	GElf_Ehdr elf_header;
-	if (gelf_getehdr(elf, &elf_header) == NULL)
+expected<ByteSpan, std::string> ELFFile::bytesAtAddress(uint64_t address, size_t length) const
+{
+	for (const auto& segment : segment_list)
 	{
-		assert(false);
-	}
-
-	uint64_t entry = elf_header.e_entry;
-
-	elf_end(elf);
-	close(fd);
+		if (segment.type != PT_LOAD || address < segment.virtual_address ||
+		    address + length > segment.virtual_address + segment.file_size)
+		{
+			continue;
+		}
 
-	return entry;
+		uint64_t offset = segment.offset + (address - segment.virtual_address);
+		if (offset + length > mapping_size)
+			break;
+		return ByteSpan{mapping + offset, length};
+	}
+	return make_unexpected("Address not loaded from ELF file: " + std::to_string(address));
 }
 
-uint16_t ELFFile::getType()
+ByteSpan ELFFile::image() const
 {
-	// Ensure the ELF library initialization doesn't fail
-	assert(elf_version(EV_CURRENT) != EV_NONE);
-
-	// Ensure the executable file can be read successfully
-	int fd = open(file_path.c_str(), O_RDONLY, 0);
-	assert(fd >= 0);
-
-	Elf* elf = elf_begin(fd, ELF_C_READ, NULL);
-	assert(elf != NULL);
+	return ByteSpan{mapping, mapping_size};
+}
 
-	// Ensure the executable is an ELF object
-	assert(elf_kind(elf) == ELF_K_ELF);
+void ELFFile::readSections()
+{
+	// Sections which can't be read are left out, as for a damaged file
+	size_t shstrndx;
+	if (elf_getshdrstrndx(elf, &shstrndx) != 0)
+		return;
 
-	GElf_Ehdr elf_header;
-	if (gelf_getehdr(elf, &elf_header) == NULL)
+	Elf_Scn* elf_section = NULL;
+	while ((elf_section = elf_nextscn(elf, elf_section)) != NULL)
 	{
-		assert(false);
-	}
+		GElf_Shdr elf_section_header;
+		if (gelf_getshdr(elf_section, &elf_section_header) != &elf_section_header)
+			continue;
 
-	uint16_t file_type = elf_header.e_type;
+		char *name;
+		if ((name = elf_strptr(elf, shstrndx, elf_section_header.sh_name)) == NULL)
+			continue;
 
-	elf_end(elf);
-	close(fd);
+		Section section;
+		section.name = name;
+		section.type = elf_section_header.sh_type;
+		section.flags = elf_section_header.sh_flags;
+		section.address = elf_section_header.sh_addr;
+		section.offset = elf_section_header.sh_offset;
+		section.size = elf_section_header.sh_size;
+		section.link = elf_section_header.sh_link;
+		section.info = elf_section_header.sh_info;
+		section.entry_size = elf_section_header.sh_entsize;
+		bool has_data = (section.type != SHT_NOBITS && section.offset <= mapping_size &&
+		                 section.size <= mapping_size - section.offset);
+		if (has_data)
+			section.data = ByteSpan{mapping + section.offset, section.size};
 
-	return file_type;
+		// Section indices start from one, as the first section header is
+		// reserved, so the list is indexed the same way
+		size_t index = elf_ndxscn(elf_section);
+		if (section_list.size() < index + 1)
+			section_list.resize(index + 1, Section{});
+		section_list[index] = section;
+
+		if (section.type == SHT_NOTE)
+			readBuildId(elf_section);
+	}
 }
 
-void ELFFile::populateSectionAddresses()
+void ELFFile::readSegments()
 {
-	// Ensure the ELF library initialization doesn't fail
-	assert(elf_version(EV_CURRENT) != EV_NONE);
+	size_t segment_count;
+	if (elf_getphdrnum(elf, &segment_count) != 0)
+		return;
 
-	// Ensure the executable file can be read successfully
-	int fd = open(file_path.c_str(), O_RDONLY, 0);
-	assert(fd >= 0);
-
-	Elf* elf = elf_begin(fd, ELF_C_READ, NULL);
-	assert(elf != NULL);
+	segment_list.reserve(segment_count);
+	for (size_t i = 0; i < segment_count; i++)
+	{
+		GElf_Phdr program_header;
+		if (gelf_getphdr(elf, i, &program_header) != &program_header)
+			continue;
 
-	// Ensure the executable is an ELF object
-	assert(elf_kind(elf) == ELF_K_ELF);
+		Segment segment;
+		segment.type = program_header.p_type;
+		segment.flags = program_header.p_flags;
+		segment.offset = program_header.p_offset;
+		segment.virtual_address = program_header.p_vaddr;
+		segment.file_size = program_header.p_filesz;
+		segment.memory_size = program_header.p_memsz;
+		segment_list.push_back(segment);
+	}
+}
 
-	size_t shstrndx;
-	assert(elf_getshdrstrndx(elf, &shstrndx) == 0);
+void ELFFile::readBuildId(Elf_Scn *note_section)
+{
+	Elf_Data *data = elf_getdata(note_section, NULL);
+	if (data == NULL)
+		return;
 
-	Elf_Scn* elf_section = NULL;
-	while ((elf_section = elf_nextscn(elf, elf_section)) != NULL)
+	// A note section may hold several notes, of which only one is the build ID
+	GElf_Nhdr note_header;
+	size_t name_offset;
+	size_t desc_offset;
+	size_t offset = 0;
+	while ((offset = gelf_getnote(data, offset, &note_header, &name_offset, &desc_offset)) > 0)
 	{
-		GElf_Shdr elf_section_header;
-		if (gelf_getshdr(elf_section, &elf_section_header) != &elf_section_header)
-		{
-			assert(false);
-		}
+		const char *name = static_cast<const char *>(data->d_buf) + name_offset;
+		bool is_gnu_note = (note_header.n_namesz == 4 && memcmp(name, "GNU", 4) == 0);
+		if (!is_gnu_note || note_header.n_type != NT_GNU_BUILD_ID)
+			continue;
 
-		char *name;
-		if ((name = elf_strptr(elf, shstrndx, elf_section_header.sh_name)) == NULL)
+		static const char hex_digits[] = "0123456789abcdef";
+		const uint8_t *desc = static_cast<const uint8_t *>(data->d_buf) + desc_offset;
+		build_id.clear();
+		for (size_t i = 0; i < note_header.n_descsz; i++)
 		{
-			assert(false);
+			build_id += hex_digits[desc[i] >> 4];
+			build_id += hex_digits[desc[i] & 0xf];
 		}
-
-		section_addresses.emplace(name, elf_section_header.sh_addr);
+		return;
 	}
+}
 
-	elf_end(elf);
-	close(fd);
-}
\ No newline at end of file
+const ELFFile::Section* ELFFile::findSection(const std::string& section_name) const
+{
+	for (const auto& section : section_list)
+	{
+		if (section.name == section_name)
+			return &section;
+	}
+	return nullptr;
+}
@@ -1,29 +1,107 @@
 #pragma once
 
+#include <stdint.h>
+#include <memory>
 #include <string>
-#include <map>
+#include <string_view>
+#include <vector>
+
+#include <libelf.h>
 
 #include "expected.hpp"
 
 using namespace nonstd;
 
+// A view of bytes within the mapped file, which is only valid for as long as
+// the ELFFile it came from
+struct ByteSpan
+{
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+};
+
+// An ELF file mapped into memory once, and shared by everything which reads
+// it. Sections and segments are views of the mapping, so none of
+// their data is copied.
 class ELFFile
 {
 public:
+	struct Section
+	{
+		std::string_view name;
+		uint32_t type;
+		uint64_t flags;
+		uint64_t address;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t link;
+		uint32_t info;
+		uint64_t entry_size;
+		// Empty for sections with no data in the file (such as .bss)
+		ByteSpan data;
+	};
+
+	struct Segment
+	{
+		uint32_t type;
+		uint32_t flags;
+		uint64_t offset;
+		uint64_t virtual_address;
+		uint64_t file_size;
+		uint64_t memory_size;
+	};
+
+	// A file which can't be mapped, or isn't an ELF object, is left with no
+	// sections or segments
 	ELFFile(std::string file_path);
+	~ELFFile();
+
+	// Opens a file which may not be an ELF object, such as a candidate debug
+	// file, failing instead of leaving it empty
+	static expected<std::shared_ptr<ELFFile>, std::string> open(const std::string& file_path);
+
+	ELFFile(const ELFFile &other) = delete;
+	ELFFile &operator=(const ELFFile &other) = delete;
 
 	std::string filePath() const;
 	uint64_t entryPoint() const;
 	bool hasPositionIndependentCode() const;
+	bool is64Bit() const;
+	bool isLittleEndian() const;
 	expected<uint64_t, std::string> sectionAddress(const std::string& section_name) const;
+	// The contents of a section as they are stored in the file, so compressed
+	// sections are returned compressed
+	expected<ByteSpan, std::string> sectionData(const std::string& section_name) const;
+	// The GNU build ID note, as a hexadecimal string
+	expected<std::string, std::string> buildId() const;
+
+	const std::vector<Section>& sections() const;
+	const std::vector<Segment>& segments() const;
+	// The bytes of the file which are loaded at a virtual address, such as
+	// the original instructions of a function
+	expected<ByteSpan, std::string> bytesAtAddress(uint64_t address, size_t length) const;
+
+	ByteSpan image() const;
 
 private:
 	std::string file_path;
+	uint8_t* mapping;
+	size_t mapping_size;
+	Elf* elf;
+
 	uint64_t entry_point;
 	uint16_t type;
-	std::map<std::string, uint64_t> section_addresses;
+	bool is_64_bit;
+	bool is_little_endian;
+	std::vector<Section> section_list;
+	std::vector<Segment> segment_list;
+	std::string build_id;
+
+	ELFFile();
 
-	uint64_t getEntryPoint();
-	uint16_t getType();
-	void populateSectionAddresses();
-};
\ No newline at end of file
+	expected<void, std::string> load();
+	void readSections();
+	void readSegments();
+	void readBuildId(Elf_Scn *note_section);
+	const Section* findSection(const std::string& section_name) const;
+};
@@ -46,7 +46,8 @@ ProcessDebugger::ProcessDebugger(const std::string& executable_name,
 	debug_info(debug_info),
 	target_name(executable_name),
 	breakpoint_lines(breakpoint_lines),
-	elf_file(std::make_unique<ELFFile>(executable_name))
+	pending_breakpoint_lines(breakpoint_lines),
+	elf_file(debug_info->getELFFile())
 {
 	is_debugging = true;
 	debug_thread = std::thread(&ProcessDebugger::runDebugger, this);
@@ -110,7 +111,16 @@ bool ProcessDebugger::runDebugger()
 		return false;
 
 	memory_mappings = std::make_unique<ProcessMemoryMappings>(tracer.traceePID());
-	createBreakpoints();
+	uint64_t load_bias = 0;
+	if (elf_file->hasPositionIndependentCode())
+	{
+		load_bias = memory_mappings->loadAddress();
+	}
+	const AddressSpace::Module *executable = address_space.add(target_name, load_bias, debug_info);
+
+	breakpoint_table = std::make_shared<BreakpointTable>();
+	if (executable != nullptr)
+		createBreakpoints(*executable);
 	createEntryBreakpoint();
 
 	breakpoint_table->enableBreakpoints(tracer);
@@ -162,27 +172,34 @@ bool ProcessDebugger::runDebugger()
 	return true;
 }
 
-void ProcessDebugger::createBreakpoints()
+std::vector<uint64_t> ProcessDebugger::createBreakpoints(const AddressSpace::Module& module)
 {
-	breakpoint_table = std::make_unique<BreakpointTable>();
-
-	uint64_t start_address_offset = 0;
-	if (elf_file->hasPositionIndependentCode())
+	std::vector<uint64_t> addresses;
+	std::vector<BreakpointLine> unresolved_lines;
+	for (const auto& bp_line : pending_breakpoint_lines)
 	{
-		start_address_offset = memory_mappings->loadAddress();
-	}
+		// Lines name their file by ID, which is only known once the file's
+		// lines have been read
+		DebugInfo::SourceLines lines = module.debug_info->getSourceFileLines(bp_line.file_name);
+		auto file_id = module.debug_info->getSourcePathId(bp_line.file_name);
+		if (!file_id)
+		{
+			unresolved_lines.push_back(bp_line);
+			continue;
+		}
 
-	for (const auto& bp_line : breakpoint_lines)
-	{
-		for (const DebugInfo::SourceLine &line : debug_info->getSourceFileLines(bp_line.file_name))
+		bool is_resolved = false;
+		for (const DebugInfo::SourceLine &line : lines)
 		{
-			bool is_match = line.file_name == bp_line.file_name && line.number == bp_line.line_number;
-			bool is_not_breakpoint = !breakpoint_table->isBreakpoint(line.address);
+			uint64_t bp_address = module.toLoadedAddress(line.address);
+			bool is_match = line.file == file_id.value() && line.number == bp_line.line_number;
+			bool is_not_breakpoint = !breakpoint_table->isBreakpoint(bp_address);
 			if (is_match && is_not_breakpoint)
 			{
-				uint64_t bp_address = start_address_offset + line.address;
 				breakpoint_table->addBreakpoint(bp_address);
 				breakpoint_lines_by_address.emplace(bp_address, bp_line);
+				addresses.push_back(bp_address);
+				is_resolved = true;
 
 				// TODO: By breaking here, you are assuming the first address found is
 				// the lowest address of this source line's assembly. This may be
@@ -190,6 +207,24 @@ void ProcessDebugger::createBreakpoints()
 				break;
 			}
 		}
+		if (!is_resolved)
+			unresolved_lines.push_back(bp_line);
+	}
+
+	pending_breakpoint_lines = std::move(unresolved_lines);
+	return addresses;
+}
+
+void ProcessDebugger::removeBreakpoints(const AddressSpace::Module& module)
+{
+	// The object's code is gone, so there's nothing to restore. The lines are
+	// pending again, in case the object is loaded again.
+	auto it = breakpoint_lines_by_address.lower_bound(module.start_address);
+	while (it != breakpoint_lines_by_address.end() && it->first < module.end_address)
+	{
+		breakpoint_table->removeBreakpoint(it->first);
+		pending_breakpoint_lines.push_back(it->second);
+		it = breakpoint_lines_by_address.erase(it);
 	}
 }
 
@@ -275,19 +310,15 @@ void ProcessDebugger::performStep(StepCursor &cursor, BreakpointAction action)
 
 void ProcessDebugger::onBreakpointHit()
 {
-	procmsg("[DEBUG] Getting breakpoint at address: 0x%lx\n", getAbsoluteIP(tracer) - 1);
-
-	// TESTING
-	auto libraries = so_observer.getLoadedObjects(tracer, *elf_file, *memory_mappings);
-	for (const auto& name : libraries)
-		procmsg("[SHARED_OBJECT] %s\n", name.c_str());
-
 	uint64_t breakpoint_address = getAbsoluteIP(tracer) - 1;
+	procmsg("[DEBUG] Getting breakpoint at address: 0x%lx\n", breakpoint_address);
+
+	auto& rendezvous_breakpoint = so_observer.getRendezvousBreakpoint();
 	if (entry_breakpoint->addr == breakpoint_address)
 	{
 		onEntryBreakpointHit();
 	}
-	else if (so_observer.getRendezvousBreakpoint()->addr == breakpoint_address)
+	else if (rendezvous_breakpoint != nullptr && rendezvous_breakpoint->addr == breakpoint_address)
 	{
 		onRendezvousBreakpointHit();
 	}
@@ -299,7 +330,10 @@ void ProcessDebugger::onBreakpointHit()
 
 void ProcessDebugger::onEntryBreakpointHit()
 {
-	so_observer.setRendezvousBreakpoint(tracer, *elf_file, *memory_mappings);
+	// The objects the executable depends on were loaded before it started,
+	// so won't be reported by the rendezvous breakpoint
+	if (so_observer.setRendezvousBreakpoint(tracer, *elf_file, *memory_mappings))
+		onSharedObjectsChanged(so_observer.update(tracer, *elf_file, *memory_mappings));
 
 	procmsg("[ENTRY_POINT] Stepping over entry breakpoint!\n");
 	entry_breakpoint->stepOver(tracer);
@@ -307,6 +341,10 @@ void ProcessDebugger::onEntryBreakpointHit()
 
 void ProcessDebugger::onRendezvousBreakpointHit()
 {
+	// The dynamic linker has finished changing its list of objects when the
+	// list is consistent, which is all the update looks at
+	onSharedObjectsChanged(so_observer.update(tracer, *elf_file, *memory_mappings));
+
 	procmsg("[ENTRY_POINT] Stepping over rendezvous breakpoint!\n");
 	auto& rendezvous_breakpoint = so_observer.getRendezvousBreakpoint();
 	rendezvous_breakpoint->stepOver(tracer);
@@ -320,12 +358,7 @@ void ProcessDebugger::onUserBreakpointHit()
 	broadcastBreakpointHit(line.file_name, line.line_number);
 
 	// Create the step cursor at the address the program is currently stopped at
-	uint64_t load_address_offset = 0;
-	if (elf_file->hasPositionIndependentCode())
-	{
-		load_address_offset = memory_mappings->loadAddress();
-	}
-	StepCursor step_cursor(debug_info, breakpoint_table, load_address_offset);
+	StepCursor step_cursor(address_space, *memory_mappings, breakpoint_table);
 
 	// Wait until an action is taken for this particular breakpoint
 	std::unique_lock<std::mutex> lck(mtx);
@@ -361,15 +394,56 @@ void ProcessDebugger::onUserBreakpointHit()
 	breakpoint_action = UNDEFINED;
 }
 
+void ProcessDebugger::onSharedObjectsChanged(const std::vector<SharedObjectEvent>& events)
+{
+	for (const auto& event : events)
+	{
+		const SharedObject& object = event.object;
+		if (event.type == SharedObjectEvent::UNLOADED)
+		{
+			const AddressSpace::Module *module = address_space.find(object.path, object.base_address);
+			if (module != nullptr)
+				removeBreakpoints(*module);
+			address_space.remove(object.path, object.base_address);
+			continue;
+		}
+
+		// Objects without debugging information can't be stepped through or
+		// inspected, so are left out
+		std::shared_ptr<DebugInfo> object_debug_info = DebugInfo::readShared(object.path);
+		if (object_debug_info == nullptr)
+			continue;
+		const AddressSpace::Module *module = address_space.add(object.path, object.base_address,
+		                                                       object_debug_info);
+
+		// The object is reported once it has been mapped, but before any of
+		// its code has run
+		if (module != nullptr && !pending_breakpoint_lines.empty())
+			breakpoint_table->enableBreakpoints(tracer, createBreakpoints(*module));
+	}
+}
+
 void ProcessDebugger::deduceValue(GetValueMessage *value_msg)
 {
-	DebugInfo::Variable var = debug_info->getVariable(value_msg->variable_name,
-	                                                  tracer.traceePID());
+	// Variables are looked up in the object the target is stopped in
+	uint64_t ip = getAbsoluteIP(tracer);
+	const AddressSpace::Module *module = address_space.find(ip);
+	if (module == nullptr)
+	{
+		value_msg->value = "Variable not locatable";
+		return;
+	}
+
+	uint64_t pc = module->toObjectAddress(ip);
+	DebugInfo::Variable var = module->debug_info->getVariable(value_msg->variable_name, tracer, pc,
+	                                                          module->load_bias);
 	value_msg->value = var.value;
 }
 
 void ProcessDebugger::getStackTrace(GetStackTraceMessage *stack_msg)
 {
+	// libunwind reads the registers itself
+	tracer.flushRegisters();
 	Unwinder unwinder(tracer.traceePID());
 	stack_msg->stack = unwinder.traceStack();
 	unwinder.reset();
@@ -19,6 +19,7 @@
 #include <string>
 #include <map>
 
+#include "AddressSpace.hpp"
 #include "ProcessTracer.hpp"
 #include "StepCursor.hpp"
 #include "Unwinder.hpp"
@@ -111,6 +112,9 @@ private:
 	ProcessTracer tracer;
 
 	std::vector<BreakpointLine> breakpoint_lines;
+	// Lines not found in any of the objects loaded so far, which are looked
+	// for again in each object loaded later
+	std::vector<BreakpointLine> pending_breakpoint_lines;
 	std::map<uint64_t, BreakpointLine> breakpoint_lines_by_address;
 	std::shared_ptr<BreakpointTable> breakpoint_table = nullptr;
 	std::unique_ptr<Breakpoint> entry_breakpoint = nullptr;
@@ -126,20 +130,24 @@ private:
 
 	BreakpointAction breakpoint_action = UNDEFINED;
 
-	std::unique_ptr<ELFFile> elf_file = nullptr;
+	std::shared_ptr<ELFFile> elf_file = nullptr;
 	std::unique_ptr<ProcessMemoryMappings> memory_mappings = nullptr;
 
 	SharedObjectObserver so_observer;
+	// The executable and the shared objects with debugging information
+	AddressSpace address_space;
 
 	bool runDebugger();
 
-	void createBreakpoints();
+	std::vector<uint64_t> createBreakpoints(const AddressSpace::Module& module);
+	void removeBreakpoints(const AddressSpace::Module& module);
 	void createEntryBreakpoint();
 
 	void onBreakpointHit();
 	void onEntryBreakpointHit();
 	void onRendezvousBreakpointHit();
 	void onUserBreakpointHit();
+	void onSharedObjectsChanged(const std::vector<SharedObjectEvent>& events);
 	void processMessageQueue();
 	void broadcastBreakpointHit(const std::string &file_name, uint64_t line_number);
 	void performStep(StepCursor &cursor, BreakpointAction action);
@@ -1,6 +1,10 @@
 #include "ProcessMemoryMappings.hpp"
 
+#include <elf.h>
+
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <string>
 
 void procmsg(const char* format, ...);
@@ -8,6 +12,7 @@ void procmsg(const char* format, ...);
 ProcessMemoryMappings::ProcessMemoryMappings(pid_t pid)
 {
 	load_address = readLoadAddressFromProcMaps(pid);
+	readDynamicLinkerRange(pid);
 }
 
 uint64_t ProcessMemoryMappings::loadAddress() const
@@ -15,6 +20,11 @@ uint64_t ProcessMemoryMappings::loadAddress() const
 	return load_address;
 }
 
+bool ProcessMemoryMappings::isInDynamicLinker(uint64_t address) const
+{
+	return address >= dynamic_linker_start && address < dynamic_linker_end;
+}
+
 uint64_t ProcessMemoryMappings::readLoadAddressFromProcMaps(pid_t pid)
 {
 	std::string pmaps_path = "/proc/" + std::to_string(pid) + "/maps";
@@ -33,4 +43,45 @@ uint64_t ProcessMemoryMappings::readLoadAddressFromProcMaps(pid_t pid)
 	std::string load_addr_str = first_line.substr(0, first_line.find("-"));
 	uint64_t load_addr = std::stoull(load_addr_str, 0, 16);
 	return load_addr;
-}
\ No newline at end of file
+}
+
+void ProcessMemoryMappings::readDynamicLinkerRange(pid_t pid)
+{
+	// The kernel passes the address the dynamic linker was loaded at in the
+	// auxiliary vector
+	std::ifstream auxv_file("/proc/" + std::to_string(pid) + "/auxv", std::ios::binary);
+	uint64_t base_address = 0;
+	Elf64_auxv_t entry;
+	while (auxv_file.read(reinterpret_cast<char*>(&entry), sizeof(entry)) && entry.a_type != AT_NULL)
+	{
+		if (entry.a_type == AT_BASE)
+			base_address = entry.a_un.a_val;
+	}
+	if (base_address == 0)
+		return;
+
+	// The dynamic linker spans every mapping of the file mapped at its base
+	std::ifstream maps_file("/proc/" + std::to_string(pid) + "/maps");
+	std::string line;
+	std::string dynamic_linker_path;
+	while (std::getline(maps_file, line))
+	{
+		std::istringstream fields(line);
+		std::string range, permissions, offset, device, inode, path;
+		fields >> range >> permissions >> offset >> device >> inode >> path;
+		if (path.empty())
+			continue;
+
+		size_t separator = range.find('-');
+		uint64_t start = std::stoull(range.substr(0, separator), 0, 16);
+		uint64_t end = std::stoull(range.substr(separator + 1), 0, 16);
+		if (start == base_address)
+		{
+			dynamic_linker_path = path;
+			dynamic_linker_start = start;
+		}
+		if (!dynamic_linker_path.empty() && path == dynamic_linker_path)
+			dynamic_linker_end = std::max(dynamic_linker_end, end);
+	}
+	procmsg("[MEMORY_MAPPINGS] Dynamic linker at 0x%lx-0x%lx\n", dynamic_linker_start, dynamic_linker_end);
+}
@@ -3,6 +3,7 @@
 #include <sys/types.h>
 
 #include <stdint.h>
+#include <string>
 
 class ProcessMemoryMappings
 {
@@ -11,8 +12,16 @@ public:
 
 	uint64_t loadAddress() const;
 
+	// Whether an address is in the code or data of the dynamic linker, which
+	// is mapped before the process starts. Statically linked executables
+	// have no dynamic linker.
+	bool isInDynamicLinker(uint64_t address) const;
+
 private:
 	uint64_t load_address;
+	uint64_t dynamic_linker_start = 0;
+	uint64_t dynamic_linker_end = 0;
 
 	uint64_t readLoadAddressFromProcMaps(pid_t pid);
-};
\ No newline at end of file
+	void readDynamicLinkerRange(pid_t pid);
+};
@@ -1,10 +1,32 @@
 #include "ProcessTracer.hpp"
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 
+// Regions larger than this many pages are read directly, rather than filling
+// the cache with pages that are unlikely to be read again
+static const size_t MAX_CACHED_REGION_PAGES = 64;
+
+static size_t pageSize()
+{
+	static const size_t page_size = sysconf(_SC_PAGESIZE);
+	return page_size;
+}
+
 ProcessTracer::ProcessTracer() :
 	is_stopped(false),
-	is_running(false)
+	is_running(false),
+	mem_fd(-1),
+	cache_stats({0, 0}),
+	has_regs(false),
+	has_fp_regs(false),
+	are_regs_dirty(false)
 {
 
 }
@@ -14,6 +36,20 @@ ProcessTracer::ProcessTracer(ProcessTracer&& other)
 	pid = other.pid;
 	is_stopped = other.is_stopped;
 	is_running = other.is_running;
+	mem_fd = other.mem_fd;
+	other.mem_fd = -1;
+	page_cache = std::move(other.page_cache);
+	cache_stats = other.cache_stats;
+	cached_regs = other.cached_regs;
+	cached_fp_regs = other.cached_fp_regs;
+	has_regs = other.has_regs;
+	has_fp_regs = other.has_fp_regs;
+	are_regs_dirty = other.are_regs_dirty;
+}
+
+ProcessTracer::~ProcessTracer()
+{
+	closeMemoryFile();
 }
 
 bool ProcessTracer::start(const std::string& executable_path)
@@ -29,8 +65,20 @@ bool ProcessTracer::start(const std::string& executable_path)
 		// Get the ID of the child process, and wait for it to stop on its first
 		// instruction
 		pid = child_pid;
+		page_cache.clear();
+		has_regs = false;
+		has_fp_regs = false;
+		are_regs_dirty = false;
 		::wait(0);
 		is_running = true;
+
+		// The file is opened after the new program has been executed, as it
+		// refers to the memory the process had when it was opened
+		closeMemoryFile();
+		std::string mem_file = "/proc/" + std::to_string(pid) + "/mem";
+		mem_fd = open64(mem_file.c_str(), O_RDWR | O_CLOEXEC);
+		if (mem_fd < 0)
+			perror("open");
 		return true;
 	}
 	else
@@ -42,6 +90,10 @@ bool ProcessTracer::start(const std::string& executable_path)
 
 ProcessTracer::Result<ProcessTracer::Signal> ProcessTracer::continueExec()
 {
+	auto prepared = prepareToResume();
+	if (!prepared.has_value())
+		return make_unexpected(prepared.error());
+
 	if (ptrace(PTRACE_CONT, pid, 0, 0) < 0)
 	{
 		perror("ptrace");
@@ -52,6 +104,10 @@ ProcessTracer::Result<ProcessTracer::Signal> ProcessTracer::continueExec()
 
 ProcessTracer::Result<ProcessTracer::Signal> ProcessTracer::singleStepExec()
 {
+	auto prepared = prepareToResume();
+	if (!prepared.has_value())
+		return make_unexpected(prepared.error());
+
 	if (ptrace(PTRACE_SINGLESTEP, pid, 0, 0))
 	{
 		perror("ptrace");
@@ -62,29 +118,44 @@ ProcessTracer::Result<ProcessTracer::Signal> ProcessTracer::singleStepExec()
 
 ProcessTracer::Result<user_regs_struct> ProcessTracer::getRegisters()
 {
-	user_regs_struct regs;
-	int result = ptrace(PTRACE_GETREGS, pid, 0, &regs);
-	if (result != -1)
+	if (!has_regs)
 	{
-		return regs;
-	}
-	else
-	{
-		return make_unexpected("Failed to get register values");
+		if (ptrace(PTRACE_GETREGS, pid, 0, &cached_regs) == -1)
+			return make_unexpected("Failed to get register values");
+		has_regs = true;
 	}
+	return cached_regs;
 }
 
 ProcessTracer::Result<void> ProcessTracer::setRegisters(const user_regs_struct& regs)
 {
-	int result = ptrace(PTRACE_SETREGS, pid, 0, &regs);
-	if (result != -1)
+	cached_regs = regs;
+	has_regs = true;
+	are_regs_dirty = true;
+	return {};
+}
+
+ProcessTracer::Result<user_fpregs_struct> ProcessTracer::getFloatingPointRegisters()
+{
+	if (!has_fp_regs)
 	{
-		return {};
+		iovec io = {&cached_fp_regs, sizeof(cached_fp_regs)};
+		if (ptrace(PTRACE_GETREGSET, pid, NT_PRFPREG, &io) == -1)
+			return make_unexpected("Failed to get floating point register values");
+		has_fp_regs = true;
 	}
-	else
+	return cached_fp_regs;
+}
+
+ProcessTracer::Result<void> ProcessTracer::flushRegisters()
+{
+	if (are_regs_dirty)
 	{
-		return make_unexpected("Failed to set register values");
+		if (ptrace(PTRACE_SETREGS, pid, 0, &cached_regs) == -1)
+			return make_unexpected("Failed to set register values");
+		are_regs_dirty = false;
 	}
+	return {};
 }
 
 ProcessTracer::Result<ProcessTracer::Text> ProcessTracer::peekText(Address address)
@@ -102,6 +173,7 @@ ProcessTracer::Result<ProcessTracer::Text> ProcessTracer::peekText(Address addre
 
 ProcessTracer::Result<void> ProcessTracer::pokeText(Address address, Text text)
 {
+	invalidatePages(address, sizeof(text));
 	int result = ptrace(PTRACE_POKETEXT, pid, address, text);
 	if (result != -1)
 	{
@@ -113,6 +185,163 @@ ProcessTracer::Result<void> ProcessTracer::pokeText(Address address, Text text)
 	}
 }
 
+ProcessTracer::Result<void> ProcessTracer::readMemory(Address address, void* buffer, size_t size)
+{
+	return readMemory({{address, buffer, size}});
+}
+
+ProcessTracer::Result<void> ProcessTracer::readMemory(const std::vector<MemoryRegion>& regions)
+{
+	const size_t page_size = pageSize();
+	auto isCached = [&](const MemoryRegion& region)
+	{
+		return region.size <= MAX_CACHED_REGION_PAGES * page_size;
+	};
+
+	// The pages missing from the cache are read together
+	std::vector<Address> missing_pages;
+	std::vector<MemoryRegion> uncached_regions;
+	for (const MemoryRegion& region : regions)
+	{
+		if (!isCached(region))
+		{
+			uncached_regions.push_back(region);
+			continue;
+		}
+
+		Address end = region.address + region.size;
+		for (Address page = region.address & ~(page_size - 1); page < end; page += page_size)
+		{
+			if (page_cache.count(page) > 0)
+				cache_stats.hits++;
+			else
+				missing_pages.push_back(page);
+		}
+	}
+	std::sort(missing_pages.begin(), missing_pages.end());
+	missing_pages.erase(std::unique(missing_pages.begin(), missing_pages.end()), missing_pages.end());
+	cache_stats.misses += missing_pages.size();
+	cachePages(missing_pages);
+
+	for (const MemoryRegion& region : regions)
+	{
+		if (!isCached(region))
+			continue;
+
+		Address address = region.address;
+		Address end = region.address + region.size;
+		char* buffer = static_cast<char*>(region.buffer);
+		while (address < end)
+		{
+			Address page = address & ~(page_size - 1);
+			auto cached_page = page_cache.find(page);
+			if (cached_page == page_cache.end())
+				return make_unexpected("Failed to read memory at specified address");
+
+			size_t size = std::min<size_t>(page + page_size, end) - address;
+			memcpy(buffer, cached_page->second.data() + (address - page), size);
+			buffer += size;
+			address += size;
+		}
+	}
+
+	if (uncached_regions.empty())
+		return {};
+	return readMemoryUncached(uncached_regions);
+}
+
+ProcessTracer::Result<void> ProcessTracer::readMemoryUncached(const std::vector<MemoryRegion>& regions)
+{
+	std::vector<iovec> local;
+	std::vector<iovec> remote;
+	for (size_t first = 0; first < regions.size(); first += IOV_MAX)
+	{
+		size_t count = std::min(regions.size() - first, static_cast<size_t>(IOV_MAX));
+		local.resize(count);
+		remote.resize(count);
+		size_t total_size = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const MemoryRegion& region = regions[first + i];
+			local[i] = {region.buffer, region.size};
+			remote[i] = {reinterpret_cast<void*>(region.address), region.size};
+			total_size += region.size;
+		}
+
+		ssize_t transferred = process_vm_readv(pid, local.data(), count, remote.data(), count, 0);
+		if (transferred == static_cast<ssize_t>(total_size))
+			continue;
+
+		// The read stops at the first region that isn't entirely mapped, and
+		// fails outright where process_vm_readv isn't permitted. The rest is
+		// read through /proc/<pid>/mem, which only fails for the regions that
+		// really can't be read.
+		size_t done = std::max<ssize_t>(transferred, 0);
+		for (size_t i = 0; i < count; i++)
+		{
+			const MemoryRegion& region = regions[first + i];
+			if (done >= region.size)
+			{
+				done -= region.size;
+				continue;
+			}
+
+			auto result = readMemoryFile(region.address + done, static_cast<char*>(region.buffer) + done,
+			                             region.size - done);
+			if (!result.has_value())
+				return result;
+			done = 0;
+		}
+	}
+	return {};
+}
+
+ProcessTracer::Result<std::string> ProcessTracer::readString(Address address, size_t max_length)
+{
+	const size_t page_size = pageSize();
+
+	// Reads don't cross into the next page until the string is known to
+	// continue, as it may not be mapped
+	std::string str;
+	char buffer[4096];
+	while (str.size() < max_length)
+	{
+		size_t size = std::min({page_size - address % page_size, sizeof(buffer), max_length - str.size()});
+		auto result = readMemory(address, buffer, size);
+		if (!result.has_value())
+			return make_unexpected(result.error());
+
+		size_t length = strnlen(buffer, size);
+		str.append(buffer, length);
+		if (length < size)
+			return str;
+		address += size;
+	}
+	return make_unexpected("String exceeds maximum length");
+}
+
+ProcessTracer::Result<void> ProcessTracer::writeMemory(Address address, const void* buffer, size_t size)
+{
+	if (mem_fd < 0)
+		return make_unexpected("Memory of the tracee isn't open for writing");
+
+	invalidatePages(address, size);
+	size_t done = 0;
+	while (done < size)
+	{
+		ssize_t result = pwrite64(mem_fd, static_cast<const char*>(buffer) + done, size - done, address + done);
+		if (result <= 0)
+			return make_unexpected("Failed to write memory at specified address");
+		done += result;
+	}
+	return {};
+}
+
+ProcessTracer::MemoryCacheStats ProcessTracer::memoryCacheStats() const
+{
+	return cache_stats;
+}
+
 pid_t ProcessTracer::traceePID() const
 {
 	return pid;
@@ -130,9 +359,24 @@ bool ProcessTracer::isRunning() const
 
 ProcessTracer& ProcessTracer::operator=(ProcessTracer&& other)
 {
+	// Closing the memory file first would close the one being moved
+	if (this == &other)
+		return *this;
+
+	closeMemoryFile();
 	pid = other.pid;
 	is_stopped = other.is_stopped;
 	is_running = other.is_running;
+	mem_fd = other.mem_fd;
+	other.mem_fd = -1;
+	page_cache = std::move(other.page_cache);
+	cache_stats = other.cache_stats;
+	cached_regs = other.cached_regs;
+	cached_fp_regs = other.cached_fp_regs;
+	has_regs = other.has_regs;
+	has_fp_regs = other.has_fp_regs;
+	are_regs_dirty = other.are_regs_dirty;
+	return *this;
 }
 
 ProcessTracer::Result<void> ProcessTracer::runTarget(const std::string& executable_path)
@@ -149,6 +393,88 @@ ProcessTracer::Result<void> ProcessTracer::runTarget(const std::string& executab
 	return {};
 }
 
+ProcessTracer::Result<void> ProcessTracer::readMemoryFile(Address address, void* buffer, size_t size)
+{
+	if (mem_fd < 0)
+		return make_unexpected("Memory of the tracee isn't open for reading");
+
+	size_t done = 0;
+	while (done < size)
+	{
+		ssize_t result = pread64(mem_fd, static_cast<char*>(buffer) + done, size - done, address + done);
+		if (result <= 0)
+			return make_unexpected("Failed to read memory at specified address");
+		done += result;
+	}
+	return {};
+}
+
+void ProcessTracer::closeMemoryFile()
+{
+	if (mem_fd >= 0)
+		close(mem_fd);
+	mem_fd = -1;
+}
+
+void ProcessTracer::cachePages(const std::vector<Address>& pages)
+{
+	const size_t page_size = pageSize();
+	std::vector<iovec> local;
+	std::vector<iovec> remote;
+	size_t first = 0;
+	while (first < pages.size())
+	{
+		size_t count = std::min(pages.size() - first, static_cast<size_t>(IOV_MAX));
+		local.resize(count);
+		remote.resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			std::vector<uint8_t>& buffer = page_cache[pages[first + i]];
+			buffer.resize(page_size);
+			local[i] = {buffer.data(), page_size};
+			remote[i] = {reinterpret_cast<void*>(pages[first + i]), page_size};
+		}
+
+		// Pages are read whole, so the read stops short at the first page
+		// that can't be read by process_vm_readv
+		ssize_t transferred = process_vm_readv(pid, local.data(), count, remote.data(), count, 0);
+		size_t read_pages = (transferred > 0) ? transferred / page_size : 0;
+		first += read_pages;
+		if (read_pages == count)
+			continue;
+
+		// The page may still be read through /proc/<pid>/mem when
+		// process_vm_readv isn't permitted. Pages which can't be read at all
+		// aren't cached, so reads of them fail.
+		Address page = pages[first];
+		if (!readMemoryFile(page, page_cache[page].data(), page_size).has_value())
+			page_cache.erase(page);
+		first++;
+	}
+}
+
+ProcessTracer::Result<void> ProcessTracer::prepareToResume()
+{
+	auto flushed = flushRegisters();
+	if (!flushed.has_value())
+	{
+		perror("ptrace");
+		return flushed;
+	}
+
+	page_cache.clear();
+	has_regs = false;
+	has_fp_regs = false;
+	return {};
+}
+
+void ProcessTracer::invalidatePages(Address address, size_t size)
+{
+	const size_t page_size = pageSize();
+	for (Address page = address & ~(page_size - 1); page < address + size; page += page_size)
+		page_cache.erase(page);
+}
+
 ProcessTracer::Result<ProcessTracer::Signal> ProcessTracer::wait()
 {
 	int wait_status;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <sys/ptrace.h>
 #include <sys/types.h>
@@ -22,21 +24,59 @@ public:
 	template <class T>
 	using Result = expected<T, std::string>;
 
+	// A range of the tracee's memory, and the buffer it is read into
+	struct MemoryRegion
+	{
+		Address address;
+		void* buffer;
+		size_t size;
+	};
+
+	struct MemoryCacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+	};
+
 	ProcessTracer();
 	ProcessTracer(const ProcessTracer&) = delete;
 	ProcessTracer(ProcessTracer&& other);
+	~ProcessTracer();
 
 	bool start(const std::string& executable_path);
 
 	Result<Signal> continueExec();
 	Result<Signal> singleStepExec();
 
+	// Registers are read once per stop, and the floating point and vector
+	// registers only when asked for. Writes are held until the tracee is
+	// resumed, so must be flushed before anything reads the registers with
+	// ptrace itself, like libunwind.
 	Result<user_regs_struct> getRegisters();
 	Result<void> setRegisters(const user_regs_struct& regs);
+	Result<user_fpregs_struct> getFloatingPointRegisters();
+	Result<void> flushRegisters();
 
 	Result<Text> peekText(Address address);
 	Result<void> pokeText(Address address, Text text);
 
+	// Reads the tracee's memory with process_vm_readv, falling back to
+	// /proc/<pid>/mem for whatever it can't read. Many small regions are read
+	// together in a single call. The pages read are cached until the tracee
+	// is resumed or its memory is written, so that everything inspecting it
+	// while it is stopped shares them.
+	Result<void> readMemory(Address address, void* buffer, size_t size);
+	Result<void> readMemory(const std::vector<MemoryRegion>& regions);
+	// Reads a null-terminated string, a page at a time
+	Result<std::string> readString(Address address, size_t max_length = 4096);
+	// Writes the tracee's memory through /proc/<pid>/mem, which can write to
+	// read-only pages such as its code
+	Result<void> writeMemory(Address address, const void* buffer, size_t size);
+
+	// Counts the pages found in the cache, and those read into it, since the
+	// tracee was started
+	MemoryCacheStats memoryCacheStats() const;
+
 	pid_t traceePID() const;
 	bool isStopped() const;
 	bool isRunning() const;
@@ -48,8 +88,27 @@ private:
 	pid_t pid;
 	bool is_stopped;
 	bool is_running;
+	// /proc/<pid>/mem, which is opened once the tracee has started and kept
+	// open for as long as it is traced
+	int mem_fd;
+
+	std::unordered_map<Address, std::vector<uint8_t>> page_cache;
+	MemoryCacheStats cache_stats;
+
+	user_regs_struct cached_regs;
+	user_fpregs_struct cached_fp_regs;
+	bool has_regs;
+	bool has_fp_regs;
+	bool are_regs_dirty;
 
 	Result<void> runTarget(const std::string& executable_path);
+	Result<void> readMemoryUncached(const std::vector<MemoryRegion>& regions);
+	Result<void> readMemoryFile(Address address, void* buffer, size_t size);
+	void closeMemoryFile();
+	void cachePages(const std::vector<Address>& pages);
+	void invalidatePages(Address address, size_t size);
+	// Writes back any registers set, and forgets them, before resuming
+	Result<void> prepareToResume();
 
 	Result<Signal> wait();
 };
\ No newline at end of file
@@ -1,9 +1,9 @@
 #include "SharedObjectObserver.hpp"
 
+#include <algorithm>
 #include <cstring>
 
 #include <elf.h>
-#include <fcntl.h>
 
 // TODO: REMOVE
 void procmsg(const char *format, ...);
@@ -15,31 +15,74 @@ SharedObjectObserver::SharedObjectObserver() :
 
 }
 
-std::vector<std::string> SharedObjectObserver::getLoadedObjects(ProcessTracer& tracer,
-                                                                ELFFile& elf_file,
-                                                                ProcessMemoryMappings& memory_mappings)
+std::vector<SharedObjectEvent> SharedObjectObserver::update(ProcessTracer& tracer,
+                                                           ELFFile& elf_file,
+                                                           ProcessMemoryMappings& memory_mappings)
 {
-	std::vector<std::string> objects;
+	std::vector<SharedObjectEvent> events;
 
 	// Get the rendezvous object from the target process's memory
 	RendezvousPtr rendezvous = getRendezvous(tracer, elf_file, memory_mappings);
-	if (rendezvous == nullptr)
-		return objects;
+	if (rendezvous == nullptr || rendezvous->r_state != r_debug::RT_CONSISTENT)
+		return events;
 
-	// Read the linked list of libraries from the rendezvous map
+	// Read the linked list of libraries from the rendezvous map. The first
+	// node is the executable, which has no name.
+	std::vector<SharedObject> objects;
+	std::map<uint64_t, SharedObject> objects_by_node;
 	link_map* link_map_addr = rendezvous->r_map;
 	while (link_map_addr)
 	{
 		uint64_t addr = reinterpret_cast<uint64_t>(link_map_addr);
 		auto map = readMemoryChunk<link_map>(tracer, addr);
-		uint64_t name_addr = (uint64_t)map->l_name;
-		std::string name = readString(tracer, name_addr);
+		if (map == nullptr)
+			return events;
 		link_map_addr = map->l_next;
 
-		objects.emplace_back(name);
+		// Nodes are freed when their objects are unloaded, so may be reused
+		// for other objects
+		SharedObject object;
+		auto known_object = objects_by_link_map.find(addr);
+		if (known_object != objects_by_link_map.end() && known_object->second.base_address == map->l_addr)
+		{
+			object = known_object->second;
+		}
+		else
+		{
+			object.path = readString(tracer, (uint64_t)map->l_name);
+			object.base_address = map->l_addr;
+		}
+
+		objects_by_node.emplace(addr, object);
+		if (!object.path.empty())
+			objects.push_back(object);
+	}
+
+	for (const auto& object : loaded_objects)
+	{
+		if (std::find(objects.begin(), objects.end(), object) == objects.end())
+		{
+			procmsg("[SO_OBSERVER] Unloaded %s from 0x%lx\n", object.path.c_str(), object.base_address);
+			events.push_back({SharedObjectEvent::UNLOADED, object});
+		}
+	}
+	for (const auto& object : objects)
+	{
+		if (std::find(loaded_objects.begin(), loaded_objects.end(), object) == loaded_objects.end())
+		{
+			procmsg("[SO_OBSERVER] Loaded %s at 0x%lx\n", object.path.c_str(), object.base_address);
+			events.push_back({SharedObjectEvent::LOADED, object});
+		}
 	}
 
-	return objects;
+	loaded_objects = std::move(objects);
+	objects_by_link_map = std::move(objects_by_node);
+	return events;
+}
+
+const std::vector<SharedObject>& SharedObjectObserver::getLoadedObjects() const
+{
+	return loaded_objects;
 }
 
 bool SharedObjectObserver::setRendezvousBreakpoint(ProcessTracer& tracer,
@@ -95,25 +138,24 @@ uint64_t SharedObjectObserver::getRendezvousAddress(ProcessTracer& tracer,
 		dynamic_section_address += memory_mappings.loadAddress();
 	}
 
-	uint64_t address = dynamic_section_address;
-	// TODO: This can be a 32-bit word on 32-bit systems
-	auto expected_word = tracer.peekText(address);
-	assert(expected_word.has_value());
-	uint64_t word = expected_word.value();
-	while (word != DT_NULL)
+	// The dynamic section is read from the process rather than the file, as
+	// the dynamic linker fills in DT_DEBUG
+	auto expected_dynamic_section = elf_file.sectionData(".dynamic");
+	assert(expected_dynamic_section.has_value());
+	std::vector<ElfW(Dyn)> entries(expected_dynamic_section.value().size / sizeof(ElfW(Dyn)));
+	auto result = tracer.readMemory(dynamic_section_address, entries.data(), entries.size() * sizeof(ElfW(Dyn)));
+	if (!result.has_value())
 	{
-		if (word == DT_DEBUG)
-		{
-			// The address is the word after DT_DEBUG
-			expected_word = tracer.peekText(address + sizeof(uint64_t));
-			assert(expected_word.has_value());
-			word = expected_word.value();
-			return word;
-		}
-		address += sizeof(uint64_t);
-		expected_word = tracer.peekText(address);
-		assert(expected_word.has_value());
-		word = expected_word.value();
+		procmsg("[SO_OBSERVER] %s: 0x%lx\n", result.error().c_str(), dynamic_section_address);
+		return 0;
+	}
+
+	for (const auto& entry : entries)
+	{
+		if (entry.d_tag == DT_NULL)
+			break;
+		if (entry.d_tag == DT_DEBUG)
+			return entry.d_un.d_ptr;
 	}
 
 	return 0;
@@ -122,45 +164,23 @@ uint64_t SharedObjectObserver::getRendezvousAddress(ProcessTracer& tracer,
 template <typename T>
 std::unique_ptr<T> SharedObjectObserver::readMemoryChunk(ProcessTracer& tracer, uint64_t addr)
 {
-	std::string mem_file = "/proc/" + std::to_string(tracer.traceePID()) + "/mem";
-	int mem_fd = open64(mem_file.c_str(), O_RDONLY);
-	lseek64(mem_fd, addr, SEEK_SET);
 	auto buffer = std::make_unique<T>();
-	read(mem_fd, buffer.get(), sizeof(T));
-	close(mem_fd);
+	auto result = tracer.readMemory(addr, buffer.get(), sizeof(T));
+	if (!result.has_value())
+	{
+		procmsg("[SO_OBSERVER] %s: 0x%lx\n", result.error().c_str(), addr);
+		return nullptr;
+	}
 	return buffer;
 }
 
 std::string SharedObjectObserver::readString(ProcessTracer& tracer, uint64_t start_addr)
 {
-	uint64_t addr = start_addr;
-	std::string str = "";
-
-	auto expected_word = tracer.peekText(addr);
-	assert(expected_word.has_value());
-	uint64_t word = expected_word.value();
-	addr += sizeof(uint64_t);
-	while (true)
+	auto expected_str = tracer.readString(start_addr);
+	if (!expected_str.has_value())
 	{
-		auto word_ptr = reinterpret_cast<unsigned char*>(&word);
-
-		for (int i = 0; i < 8; ++i)
-		{
-			if (word_ptr[i])
-			{
-				str += word_ptr[i];
-			}
-			else
-			{
-				start_addr = addr + i;
-				return str;
-			}
-		}
-		expected_word = tracer.peekText(addr);
-		assert(expected_word.has_value());
-		word = expected_word.value();
-		addr += sizeof(uint64_t);
+		procmsg("[SO_OBSERVER] %s: 0x%lx\n", expected_str.error().c_str(), start_addr);
+		return "";
 	}
-
-	return str;
-}
\ No newline at end of file
+	return expected_str.value();
+}
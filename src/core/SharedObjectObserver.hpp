@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -11,6 +12,34 @@
 #include "ProcessMemoryMappings.hpp"
 #include "ProcessTracer.hpp"
 
+// A shared object mapped into the target process
+struct SharedObject
+{
+	std::string path;
+	// The difference between the addresses the object was linked at and the
+	// addresses it was loaded at
+	uint64_t base_address;
+
+	bool operator==(const SharedObject& other) const
+	{
+		return path == other.path && base_address == other.base_address;
+	}
+};
+
+struct SharedObjectEvent
+{
+	enum Type
+	{
+		LOADED,
+		UNLOADED
+	};
+
+	Type type;
+	SharedObject object;
+};
+
+// Tracks the shared objects loaded by the dynamic linker, which reports each
+// change to them by calling the function at r_brk in the rendezvous structure
 class SharedObjectObserver
 {
 public:
@@ -18,9 +47,15 @@ public:
 
 	SharedObjectObserver();
 
-	std::vector<std::string> getLoadedObjects(ProcessTracer& tracer,
-	                                          ELFFile& elf_file,
-	                                          ProcessMemoryMappings& memory_mappings);
+	// Updates the loaded objects from the dynamic linker's list of them,
+	// returning the objects loaded and unloaded since the last update. Only
+	// needs calling once the rendezvous breakpoint is set, and each time it
+	// is hit. The list is left alone while the dynamic linker is changing it.
+	std::vector<SharedObjectEvent> update(ProcessTracer& tracer,
+	                                      ELFFile& elf_file,
+	                                      ProcessMemoryMappings& memory_mappings);
+
+	const std::vector<SharedObject>& getLoadedObjects() const;
 
 	bool setRendezvousBreakpoint(ProcessTracer& tracer, ELFFile& elf_file,
 	                             ProcessMemoryMappings& memory_mappings);
@@ -31,6 +66,11 @@ private:
 	uint64_t rendezvous_address;
 	std::unique_ptr<Breakpoint> rendezvous_breakpoint;
 
+	std::vector<SharedObject> loaded_objects;
+	// The objects described by each node of the list when it was last read,
+	// so that the names of the objects already known aren't read again
+	std::map<uint64_t, SharedObject> objects_by_link_map;
+
 	RendezvousPtr getRendezvous(ProcessTracer& tracer, ELFFile& elf_file,
 	                            ProcessMemoryMappings& memory_mappings);
 	
@@ -0,0 +1,37 @@
+#include "SourcePaths.hpp"
+
+uint32_t SourcePathTable::intern(const std::string &path)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = ids.find(path);
+	if (it != ids.end())
+		return it->second;
+
+	uint32_t id = paths.size();
+	paths.push_back(path);
+	ids.emplace(paths.back(), id);
+	return id;
+}
+
+expected<uint32_t, std::string> SourcePathTable::find(const std::string &path) const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = ids.find(path);
+	if (it == ids.end())
+		return make_unexpected("Unknown source path: " + path);
+	return it->second;
+}
+
+const std::string &SourcePathTable::path(uint32_t id) const
+{
+	static const std::string unknown_path = "<file_name_not_found>";
+
+	std::lock_guard<std::mutex> lock(mtx);
+	return (id < paths.size()) ? paths[id] : unknown_path;
+}
+
+size_t SourcePathTable::size() const
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return paths.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "expected.hpp"
+
+using namespace nonstd;
+
+// A row of a line table. The file is an ID in the SourcePathTable of the
+// debug information it was read from, so that rows are small and can be
+// handed out without copying any paths.
+struct SourceLine
+{
+	uint64_t address;
+	uint32_t number;
+	uint32_t file;
+};
+
+// Every source path named by an executable's line tables, each stored once
+// and given a 32-bit ID. IDs and the paths they refer to stay valid for as
+// long as the table does.
+class SourcePathTable
+{
+public:
+	// Gets the ID of a path, adding it if it hasn't been seen before
+	uint32_t intern(const std::string &path);
+	expected<uint32_t, std::string> find(const std::string &path) const;
+	const std::string &path(uint32_t id) const;
+	size_t size() const;
+
+private:
+	// Guards the table, as line tables are decoded by several workers
+	mutable std::mutex mtx;
+	// A deque never moves its elements, so the views keying the map and the
+	// references handed out stay valid as paths are added
+	std::deque<std::string> paths;
+	std::unordered_map<std::string_view, uint32_t> ids;
+};
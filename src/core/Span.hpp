@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+// A view of an array owned by something else, such as a cached table. It
+// stays valid only as long as its owner does, and the owner doesn't resize
+// the array.
+template <typename T>
+class Span
+{
+public:
+	Span() = default;
+	Span(const T *data, size_t size) :
+		first(data),
+		count(size) {}
+
+	const T *begin() const
+	{
+		return first;
+	}
+
+	const T *end() const
+	{
+		return first + count;
+	}
+
+	const T &operator[](size_t index) const
+	{
+		return first[index];
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+private:
+	const T *first = nullptr;
+	size_t count = 0;
+};
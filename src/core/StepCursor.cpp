@@ -2,15 +2,16 @@
 
 #include <set>
 
+#include "ELFFile.hpp"
 #include "Unwinder.hpp"
 
-StepCursor::StepCursor(std::shared_ptr<DebugInfo> debug_info,
-                       std::shared_ptr<BreakpointTable> user_breakpoints,
-                       uint64_t load_address_offset)
+StepCursor::StepCursor(const AddressSpace& address_space,
+                       const ProcessMemoryMappings& memory_mappings,
+                       std::shared_ptr<BreakpointTable> user_breakpoints) :
+	address_space(address_space),
+	memory_mappings(memory_mappings)
 {
-	this->debug_info = debug_info;
 	this->user_breakpoints = user_breakpoints;
-	this->load_address_offset = load_address_offset;
 }
 
 void StepCursor::stepOver(ProcessTracer& tracer)
@@ -22,7 +23,7 @@ void StepCursor::stepOver(ProcessTracer& tracer)
 	// Single step over the current instruction to avoid getting stuck on a
 	// breakpoint on the same line
 	uint64_t pre_step_address = getCurrentAddress(tracer);
-	uint64_t pre_step_ret_address = getReturnAddress(tracer.traceePID());
+	uint64_t pre_step_ret_address = getReturnAddress(tracer);
 	tracer.singleStepExec();
 
 	// Create breakpoints on every line of this function apart from the current,
@@ -53,7 +54,7 @@ void StepCursor::stepInto(ProcessTracer& tracer)
 	// Get the current and return addresses, then single step to avoid a
 	// breakpoint set on the current instruction
 	uint64_t pre_step_address = getCurrentAddress(tracer);
-	uint64_t pre_step_ret_address = getReturnAddress(tracer.traceePID());
+	uint64_t pre_step_ret_address = getReturnAddress(tracer);
 	bool has_made_call = isCallInstruction(pre_step_address, tracer);
 	tracer.singleStepExec();
 
@@ -81,6 +82,19 @@ void StepCursor::stepInto(ProcessTracer& tracer)
 	// executed.
 	if (isStoppedAtBreakpoint(internal_breakpoints, tracer))
 		rewindIP(tracer);
+
+	// Calls into shared objects go through a PLT stub, and the first call
+	// through each stub also goes through the dynamic linker to bind it. Only
+	// those are single stepped, as they end by jumping to the callee. If the
+	// callee has no lines either, it is run until it returns to the caller.
+	if (!has_made_call || !tracer.isRunning())
+		return;
+
+	while (tracer.isRunning() && isInTrampoline(getCurrentAddress(tracer)))
+		tracer.singleStepExec();
+
+	if (tracer.isRunning() && !isInFunctionWithLines(getCurrentAddress(tracer)))
+		runToCaller(tracer);
 }
 
 void StepCursor::stepOut(ProcessTracer& tracer)
@@ -91,7 +105,7 @@ void StepCursor::stepOut(ProcessTracer& tracer)
 
 	// Get the return address, then single step to avoid a breakpoint set on the
 	// current instruction
-	uint64_t pre_step_ret_address = getReturnAddress(tracer.traceePID());
+	uint64_t pre_step_ret_address = getReturnAddress(tracer);
 	tracer.singleStepExec();
 
 	// Initialise and enable a breakpoint for the next line after the return
@@ -120,25 +134,30 @@ uint64_t StepCursor::getCurrentAddress(ProcessTracer& tracer)
 	return regs.rip;
 }
 
+uint64_t StepCursor::getStackPointer(ProcessTracer& tracer)
+{
+	auto expected_regs = tracer.getRegisters();
+	assert(expected_regs.has_value());
+	return expected_regs.value().rsp;
+}
+
 uint64_t StepCursor::getCurrentLineNumber(ProcessTracer& tracer)
 {
 	uint64_t current_address = getCurrentAddress(tracer);
-	uint64_t relative_address = current_address - load_address_offset;
-	auto lines = debug_info->getFunctionLines(relative_address);
-	for (auto line : lines)
-	{
-		if (line.address == relative_address)
-		{
-			return line.number;
-		}
-	}
-	assert(!"Current instruction address does not belong to a known function!");
+	const AddressSpace::Module *module = address_space.find(current_address);
+	assert(module != nullptr && "Current instruction address does not belong to a known object!");
+	auto expected_line = module->debug_info->getLine(module->toObjectAddress(current_address));
+	assert(expected_line.has_value() &&
+	       "Current instruction address does not belong to a known source line!");
+	return expected_line.value().number;
 }
 
 std::string StepCursor::getCurrentSourceFile(ProcessTracer& tracer)
 {
 	uint64_t current_address = getCurrentAddress(tracer);
-	auto expected_function = debug_info->getFunction(current_address - load_address_offset);
+	const AddressSpace::Module *module = address_space.find(current_address);
+	assert(module != nullptr && "Current instruction address does not belong to a known object!");
+	auto expected_function = module->debug_info->getFunction(module->toObjectAddress(current_address));
 	assert(expected_function.has_value() &&
 	       "Current instruction address does not belong to a known function!");
 	return expected_function.value().decl_file;
@@ -150,12 +169,15 @@ void StepCursor::addSubprogramBreakpoints(BreakpointTable &internal,
 {
 	// Set breakpoints on lines which don't have a user breakpoint, and which
 	// aren't the line currently stopped on (if desired)
-	uint64_t relative_address = address - load_address_offset;
-	auto lines = debug_info->getFunctionLines(relative_address);
+	const AddressSpace::Module *module = address_space.find(address);
+	if (module == nullptr)
+		return;
+
+	auto lines = module->debug_info->getFunctionLines(module->toObjectAddress(address));
 	std::set<uint64_t> used_lines;
 	for (const auto &line : lines)
 	{
-		uint64_t loaded_address = line.address + load_address_offset;
+		uint64_t loaded_address = module->toLoadedAddress(line.address);
 
 		if (!user_breakpoints->isBreakpoint(loaded_address) &&
 		    !internal.isBreakpoint(loaded_address) &&
@@ -172,13 +194,17 @@ void StepCursor::addReturnBreakpoint(BreakpointTable &internal,
                                      ProcessTracer& tracer,
                                      uint64_t address)
 {
-	uint64_t relative_address = address - load_address_offset;
-	auto lines = debug_info->getFunctionLines(relative_address);
+	// The caller may be in a different object to the callee
+	const AddressSpace::Module *module = address_space.find(address);
+	if (module == nullptr)
+		return;
+
+	auto lines = module->debug_info->getFunctionLines(module->toObjectAddress(address));
 	uint64_t next_closest_address = std::numeric_limits<uint64_t>::max();
 	bool address_found = false;
 	for (const auto &line : lines)
 	{
-		uint64_t loaded_address = line.address + load_address_offset;
+		uint64_t loaded_address = module->toLoadedAddress(line.address);
 
 		bool is_higher_address = loaded_address >= address;
 		bool is_closer_address = loaded_address < next_closest_address;
@@ -198,9 +224,11 @@ void StepCursor::addReturnBreakpoint(BreakpointTable &internal,
 	}
 }
 
-uint64_t StepCursor::getReturnAddress(pid_t pid)
+uint64_t StepCursor::getReturnAddress(ProcessTracer& tracer)
 {
-	Unwinder unwinder(pid);
+	// libunwind reads the registers itself
+	tracer.flushRegisters();
+	Unwinder unwinder(tracer.traceePID());
 	unwinder.unwindStep();
 	return unwinder.getRegisterValue(UNW_REG_IP);
 }
@@ -220,12 +248,84 @@ void StepCursor::stepOverBreakpoint(BreakpointTable& table, ProcessTracer& trace
 
 bool StepCursor::isCallInstruction(uint64_t address, ProcessTracer& tracer)
 {
+	// Code loaded from a file is read from its mapping, which also holds the
+	// instructions hidden by any breakpoints. Other code is read from the
+	// tracee.
+	const AddressSpace::Module *module = address_space.find(address);
+	if (module != nullptr)
+	{
+		auto expected_bytes = module->debug_info->getELFFile()->bytesAtAddress(module->toObjectAddress(address), 1);
+		if (expected_bytes.has_value())
+			return (expected_bytes.value().data[0] & 0xE8) == 0xE8;
+	}
+
 	auto expected_data = tracer.peekText(address);
 	assert(expected_data.has_value());
 	uint64_t data = expected_data.value();
 	return (data & 0xE8) == 0xE8;
 }
 
+bool StepCursor::isInFunctionWithLines(uint64_t address)
+{
+	const AddressSpace::Module *module = address_space.find(address);
+	return module != nullptr && module->debug_info->getFunction(module->toObjectAddress(address)).has_value();
+}
+
+bool StepCursor::isInTrampoline(uint64_t address)
+{
+	if (memory_mappings.isInDynamicLinker(address))
+		return true;
+
+	// PLT stubs are in the objects making the calls, outside their functions
+	const AddressSpace::Module *module = address_space.find(address);
+	if (module == nullptr)
+		return false;
+
+	uint64_t object_address = module->toObjectAddress(address);
+	for (const auto &section : module->debug_info->getELFFile()->sections())
+	{
+		bool is_plt = section.name == ".plt" || section.name == ".plt.sec" || section.name == ".plt.got";
+		if (is_plt && object_address >= section.address && object_address < section.address + section.size)
+			return true;
+	}
+	return false;
+}
+
+void StepCursor::runToCaller(ProcessTracer& tracer)
+{
+	// Once the callee has jumped out of the PLT stub, the return address
+	// pushed by the call is still on top of the stack
+	uint64_t callee_stack_pointer = getStackPointer(tracer);
+	uint64_t return_address = 0;
+	if (!tracer.readMemory(callee_stack_pointer, &return_address, sizeof(return_address)).has_value())
+		return;
+
+	BreakpointTable return_breakpoint;
+	if (!user_breakpoints->isBreakpoint(return_address))
+	{
+		return_breakpoint.addBreakpoint(return_address);
+		return_breakpoint.getBreakpoint(return_address).enable(tracer);
+	}
+
+	// A recursive call back into the caller may reach the return address in
+	// a deeper frame, which is passed over. Returning pops the address, so
+	// leaves the stack pointer above where it was in the callee.
+	tracer.continueExec();
+	while (tracer.isRunning() && isStoppedAtBreakpoint(return_breakpoint, tracer) &&
+	       getStackPointer(tracer) <= callee_stack_pointer)
+	{
+		stepOverBreakpoint(return_breakpoint, tracer);
+		tracer.continueExec();
+	}
+
+	if (tracer.isRunning())
+	{
+		return_breakpoint.disableBreakpoints(tracer);
+		if (isStoppedAtBreakpoint(return_breakpoint, tracer))
+			rewindIP(tracer);
+	}
+}
+
 bool StepCursor::hasHitBreakpoint(BreakpointTable &internal, ProcessTracer& tracer)
 {
 	uint64_t bp_address = getCurrentAddress(tracer) - 1;
@@ -239,6 +339,6 @@ void StepCursor::rewindIP(ProcessTracer& tracer)
 	auto expected_regs = tracer.getRegisters();
 	assert(expected_regs.has_value());
 	user_regs_struct regs = expected_regs.value();
-	regs.rip = getCurrentAddress(tracer) - 1;
+	regs.rip -= 1;
 	tracer.setRegisters(regs);
 }
\ No newline at end of file
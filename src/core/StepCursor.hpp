@@ -10,8 +10,9 @@
 #include <string>
 #include <vector>
 
-#include "DebugInfo.hpp"
+#include "AddressSpace.hpp"
 #include "BreakpointTable.hpp"
+#include "ProcessMemoryMappings.hpp"
 #include "ProcessTracer.hpp"
 
 // This will improve upon the previous step cursor. Instead of checking each
@@ -21,9 +22,11 @@
 class StepCursor
 {
 public:
-	StepCursor(std::shared_ptr<DebugInfo> debug_info,
-	           std::shared_ptr<BreakpointTable> user_breakpoints,
-	           uint64_t load_address_offset);
+	// Addresses are looked up in whichever of the loaded objects they belong
+	// to, so steps can go into and out of shared objects
+	StepCursor(const AddressSpace& address_space,
+	           const ProcessMemoryMappings& memory_mappings,
+	           std::shared_ptr<BreakpointTable> user_breakpoints);
 
 	void stepOver(ProcessTracer& tracer);
 	void stepInto(ProcessTracer& tracer);
@@ -34,21 +37,26 @@ public:
 	std::string getCurrentSourceFile(ProcessTracer& tracer);
 
 private:
-	std::shared_ptr<DebugInfo> debug_info = nullptr;
+	const AddressSpace& address_space;
+	const ProcessMemoryMappings& memory_mappings;
 	std::shared_ptr<BreakpointTable> user_breakpoints = nullptr;
-	uint64_t load_address_offset;
 
 	void addSubprogramBreakpoints(BreakpointTable &internal, ProcessTracer& tracer,
 	                              uint64_t address);
 	void addReturnBreakpoint(BreakpointTable &internal, ProcessTracer& tracer,
 	                         uint64_t address);
 
-	uint64_t getReturnAddress(pid_t pid);
+	uint64_t getReturnAddress(ProcessTracer& tracer);
+	uint64_t getStackPointer(ProcessTracer& tracer);
 
 	bool isStoppedAtBreakpoint(BreakpointTable& table, ProcessTracer& tracer);
 	void stepOverBreakpoint(BreakpointTable& table, ProcessTracer& tracer);
 
 	bool isCallInstruction(uint64_t address, ProcessTracer& tracer);
+	bool isInFunctionWithLines(uint64_t address);
+	bool isInTrampoline(uint64_t address);
+
+	void runToCaller(ProcessTracer& tracer);
 
 	bool hasHitBreakpoint(BreakpointTable &internal, ProcessTracer& tracer);
 
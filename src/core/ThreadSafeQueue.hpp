@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <queue>
 #include <mutex>
 
@@ -26,7 +27,7 @@ public:
 		return item_queue.empty();
 	}
 
-	std::unique_ptr<DebugMessage> tryPop()
+	std::unique_ptr<T> tryPop()
 	{
 		std::lock_guard<std::mutex> lock(mtx);
 		if (item_queue.empty())
@@ -36,7 +37,7 @@ public:
 
 		std::unique_ptr<T> popped_value = std::move(item_queue.front());
 		item_queue.pop();
-		return std::move(popped_value);
+		return popped_value;
 	}
 
 private:
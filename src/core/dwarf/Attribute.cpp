@@ -26,8 +26,10 @@ Attribute<DW_AT_type>::value_type Attribute<DW_AT_type>::value(const Dwarf_Attri
 {
 	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
 
+	// Resolve to a .debug_info offset rather than one relative to the CU, so
+	// that it can be passed to DwarfInfoReader::getDIEByOffset
 	value_type value;
-	dwarf_formref(attr, &value, nullptr);
+	dwarf_global_formref(attr, &value, nullptr);
 	return value;
 }
 
@@ -136,6 +138,72 @@ Attribute<DW_AT_decl_line>::value_type Attribute<DW_AT_decl_line>::value(const D
 {
 	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
 
+	value_type value;
+	dwarf_formudata(attr, &value, nullptr);
+	return value;
+}
+
+template <>
+Attribute<DW_AT_ranges>::value_type Attribute<DW_AT_ranges>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
+	// DWARF4 uses the sec_offset form, whereas earlier versions use a constant
+	value_type value;
+	if (dwarf_global_formref(attr, &value, nullptr) != DW_DLV_OK)
+	{
+		Dwarf_Unsigned data = 0;
+		dwarf_formudata(attr, &data, nullptr);
+		value = data;
+	}
+	return value;
+}
+
+template <>
+Attribute<DW_AT_specification>::value_type Attribute<DW_AT_specification>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
+	value_type value;
+	dwarf_global_formref(attr, &value, nullptr);
+	return value;
+}
+
+template <>
+Attribute<DW_AT_abstract_origin>::value_type Attribute<DW_AT_abstract_origin>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
+	value_type value;
+	dwarf_global_formref(attr, &value, nullptr);
+	return value;
+}
+
+template <>
+Attribute<DW_AT_dwo_name>::value_type Attribute<DW_AT_dwo_name>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
+	value_type value;
+	dwarf_formstring(attr, &value, nullptr);
+	return value;
+}
+
+template <>
+Attribute<DW_AT_GNU_dwo_name>::value_type Attribute<DW_AT_GNU_dwo_name>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
+	value_type value;
+	dwarf_formstring(attr, &value, nullptr);
+	return value;
+}
+
+template <>
+Attribute<DW_AT_GNU_dwo_id>::value_type Attribute<DW_AT_GNU_dwo_id>::value(const Dwarf_Attribute &attr)
+{
+	assert(isMatchingType(attr) && "Dwarf_Attribute code doesn't match the defined code!");
+
 	value_type value;
 	dwarf_formudata(attr, &value, nullptr);
 	return value;
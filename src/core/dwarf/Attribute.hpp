@@ -1,6 +1,7 @@
 #ifndef _ATTRIBUTE_H_
 #define _ATTRIBUTE_H_
 
+#include <stdint.h>
 #include <string>
 #include <cassert>
 
@@ -13,6 +14,13 @@ struct ExprLoc
 	Dwarf_Ptr ptr;
 };
 
+// A half-open [low_pc, high_pc) range of addresses covered by a DIE
+struct PCRange
+{
+	uint64_t low_pc;
+	uint64_t high_pc;
+};
+
 // ================ Mapping attribute tags to their value types ================
 
 template <Dwarf_Half CODE>
@@ -92,6 +100,43 @@ struct AttributeCode<DW_AT_decl_line>
 	typedef Dwarf_Unsigned value_type;
 };
 
+template <>
+struct AttributeCode<DW_AT_ranges>
+{
+	// Offset into the .debug_ranges section
+	typedef Dwarf_Off value_type;
+};
+
+template <>
+struct AttributeCode<DW_AT_specification>
+{
+	typedef Dwarf_Off value_type;
+};
+
+template <>
+struct AttributeCode<DW_AT_abstract_origin>
+{
+	typedef Dwarf_Off value_type;
+};
+
+template <>
+struct AttributeCode<DW_AT_dwo_name>
+{
+	typedef char * value_type;
+};
+
+template <>
+struct AttributeCode<DW_AT_GNU_dwo_name>
+{
+	typedef char * value_type;
+};
+
+template <>
+struct AttributeCode<DW_AT_GNU_dwo_id>
+{
+	typedef Dwarf_Unsigned value_type;
+};
+
 // ================ Calculating the values for the value types ================
 
 template <Dwarf_Half CODE>
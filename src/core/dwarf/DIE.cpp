@@ -5,15 +5,71 @@
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
 
+AttributeList::AttributeList(const Dwarf_Debug &dbg, const Dwarf_Die &die) :
+	dbg(dbg),
+	attrs(nullptr),
+	attr_count(0)
+{
+	Dwarf_Error err;
+	int result = dwarf_attrlist(die, &attrs, &attr_count, &err);
+	is_valid = (result != DW_DLV_ERROR);
+
+	// A DIE without attributes has no list to deallocate
+	if (result != DW_DLV_OK)
+	{
+		attrs = nullptr;
+		attr_count = 0;
+	}
+}
+
+AttributeList::~AttributeList()
+{
+	if (attrs == nullptr)
+		return;
+
+	for (Dwarf_Signed i = 0; i < attr_count; i++)
+		dwarf_dealloc(dbg, attrs[i], DW_DLA_ATTR);
+	dwarf_dealloc(dbg, attrs, DW_DLA_LIST);
+}
+
+bool AttributeList::isValid() const
+{
+	return is_valid;
+}
+
+Dwarf_Signed AttributeList::size() const
+{
+	return attr_count;
+}
+
+const Dwarf_Attribute &AttributeList::operator[](Dwarf_Signed index) const
+{
+	return attrs[index];
+}
+
 DIE::DIE(const Dwarf_Debug &dbg, const Dwarf_Die &die)
 {
 	this->dbg = dbg;
 	this->die = die;
-	setTagName();
+	this->tree = nullptr;
+	this->index = DIETree::NO_DIE;
+	setTag();
 }
 
-Dwarf_Off DIE::getCUOffset()
+DIE::DIE(const DIETree &tree, uint32_t index)
 {
+	this->dbg = nullptr;
+	this->die = nullptr;
+	this->tag = tree[index].tag;
+	this->tree = &tree;
+	this->index = index;
+}
+
+Dwarf_Off DIE::getCUOffset() const
+{
+	if (tree != nullptr)
+		return (*tree)[tree->getCompileUnit(index)].offset;
+
 	Dwarf_Off cu_offset;
 	Dwarf_Error err;
 	if (dwarf_CU_dieoffset_given_die(die, &cu_offset, &err) != DW_DLV_OK)
@@ -25,6 +81,16 @@ std::vector<DIE> DIE::getChildren()
 {
 	std::vector<DIE> children;
 
+	if (tree != nullptr)
+	{
+		for (uint32_t child = (*tree)[index].first_child; child != DIETree::NO_DIE;
+		     child = (*tree)[child].next_sibling)
+		{
+			children.emplace_back(*tree, child);
+		}
+		return children;
+	}
+
 	// Check that this DIE has at least 1 child
 	Dwarf_Die child_die;
 	Dwarf_Error err;
@@ -56,13 +122,83 @@ std::vector<DIE> DIE::getChildren()
 	return children;
 }
 
+std::vector<PCRange> DIE::getPCRanges() const
+{
+	if (tree != nullptr)
+		return tree->getPCRanges(index);
+
+	std::vector<PCRange> ranges;
+	Dwarf_Error err;
+
+	// A contiguous range is described by a low and high PC pair. From DWARF4
+	// onwards, the high PC may be encoded as an offset from the low PC.
+	Dwarf_Addr low_pc, high_pc;
+	Dwarf_Half high_pc_form;
+	enum Dwarf_Form_Class high_pc_class;
+	if (dwarf_lowpc(die, &low_pc, &err) == DW_DLV_OK &&
+	    dwarf_highpc_b(die, &high_pc, &high_pc_form, &high_pc_class, &err) == DW_DLV_OK)
+	{
+		if (high_pc_class == DW_FORM_CLASS_CONSTANT)
+			high_pc += low_pc;
+		ranges.push_back({low_pc, high_pc});
+		return ranges;
+	}
+
+	// Otherwise, non-contiguous ranges are listed in .debug_ranges
+	auto expected_ranges_offset = getAttributeValue<DW_AT_ranges>();
+	if (!expected_ranges_offset)
+		return ranges;
+
+	Dwarf_Ranges *entries;
+	Dwarf_Signed entry_count;
+	Dwarf_Unsigned byte_count;
+	int result = dwarf_get_ranges(dbg, expected_ranges_offset.value(), &entries,
+	                              &entry_count, &byte_count, &err);
+	if (result != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Error in dwarf_get_ranges!\n");
+		return ranges;
+	}
+
+	// Range entries are relative to the base address of the compilation unit,
+	// unless a base address selection entry overrides it
+	uint64_t base_address = getCUBaseAddress();
+	for (Dwarf_Signed i = 0; i < entry_count; i++)
+	{
+		const Dwarf_Ranges &entry = entries[i];
+		if (entry.dwr_type == DW_RANGES_ENTRY && entry.dwr_addr1 != entry.dwr_addr2)
+			ranges.push_back({base_address + entry.dwr_addr1, base_address + entry.dwr_addr2});
+		else if (entry.dwr_type == DW_RANGES_ADDRESS_SELECTION)
+			base_address = entry.dwr_addr2;
+	}
+	dwarf_ranges_dealloc(dbg, entries, entry_count);
+
+	return ranges;
+}
+
+Dwarf_Half DIE::getTag() const
+{
+	return tag;
+}
+
+// Gets the name of this DIE's tag. This should only be used for display, as
+// tags can be compared directly using getTag().
 std::string DIE::getTagName() const
 {
+	const char *tag_name = 0;
+	if (dwarf_get_TAG_name(tag, &tag_name) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Error in dwarf_get_TAG_name!\n");
+		return "<unknown_tag>";
+	}
 	return tag_name;
 }
 
-Dwarf_Off DIE::getOffset()
+Dwarf_Off DIE::getOffset() const
 {
+	if (tree != nullptr)
+		return (*tree)[index].offset;
+
 	Dwarf_Off offset;
 	Dwarf_Error err;
 	if (dwarf_dieoffset(die, &offset, &err) != DW_DLV_OK)
@@ -70,24 +206,51 @@ Dwarf_Off DIE::getOffset()
 	return offset;
 }
 
-void DIE::setTagName()
+void DIE::setTag()
 {
-	const char *tag_name = 0;
-	Dwarf_Half tag;
 	Dwarf_Error err;
-
-	// Sets a pointer to the tag of this DIE
-	if (dwarf_tag(die, &tag, &err))
+	if (dwarf_tag(die, &tag, &err) != DW_DLV_OK)
+	{
 		procmsg("[DWARF_ERROR] Error in dwarf_tag!\n");
+		tag = 0;
+	}
+}
 
-	// Gets the tag name from the tag pointer
-	if (dwarf_get_TAG_name(tag, &tag_name) != DW_DLV_OK)
-		procmsg("[DWARF_ERROR] Error in dwarf_get_TAG_name!\n");
+uint64_t DIE::getCUBaseAddress() const
+{
+	Dwarf_Off cu_offset;
+	Dwarf_Die cu_die;
+	Dwarf_Error err;
+	if (dwarf_CU_dieoffset_given_die(die, &cu_offset, &err) != DW_DLV_OK ||
+	    dwarf_offdie(dbg, cu_offset, &cu_die, &err) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Failed to find the compilation unit of a DIE!\n");
+		return 0;
+	}
 
-	this->tag_name = tag_name;
+	// A compilation unit without a low PC has a base address of zero
+	Dwarf_Addr base_address = 0;
+	dwarf_lowpc(cu_die, &base_address, &err);
+	dwarf_dealloc(dbg, cu_die, DW_DLA_DIE);
+	return base_address;
 }
 
 const Dwarf_Die &DIE::get() const
 {
 	return die;
+}
+
+const Dwarf_Debug &DIE::getDebug() const
+{
+	return dbg;
+}
+
+const DIETree *DIE::getTree() const
+{
+	return tree;
+}
+
+uint32_t DIE::getTreeIndex() const
+{
+	return index;
 }
\ No newline at end of file
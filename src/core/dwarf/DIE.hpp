@@ -1,6 +1,9 @@
 #ifndef _DIE_H_
 #define _DIE_H_
 
+#include <cstddef>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <string>
 
@@ -11,65 +14,184 @@
 using namespace nonstd;
 
 #include "Attribute.hpp"
+#include "DIETree.hpp"
 
+// Owns the attribute list of a DIE, returning it to libdwarf on destruction
+class AttributeList
+{
+public:
+	AttributeList(const Dwarf_Debug &dbg, const Dwarf_Die &die);
+	~AttributeList();
+
+	AttributeList(const AttributeList &other) = delete;
+	AttributeList &operator=(const AttributeList &other) = delete;
+
+	bool isValid() const;
+	Dwarf_Signed size() const;
+	const Dwarf_Attribute &operator[](Dwarf_Signed index) const;
+
+private:
+	Dwarf_Debug dbg;
+	Dwarf_Attribute *attrs;
+	Dwarf_Signed attr_count;
+	bool is_valid;
+};
+
+template <Dwarf_Half CODE>
+using AttributeValue = expected<typename Attribute<CODE>::value_type, std::string>;
+
+template <Dwarf_Half... CODES>
+using AttributeValues = std::tuple<AttributeValue<CODES>...>;
+
+// A DIE is either read through libdwarf on demand, or is a record of a DIETree
+// which has already been decoded
 class DIE
 {
 public:
 	DIE(const Dwarf_Debug &dbg, const Dwarf_Die &die);
+	DIE(const DIETree &tree, uint32_t index);
 
-	template <Dwarf_Half CODE>
-	expected<typename Attribute<CODE>::value_type, std::string> getAttributeValue() const
+	// Fetches the values of several attributes with a single pass over the
+	// attribute list, e.g.
+	// auto [name, line] = die.getAttributeValues<DW_AT_name, DW_AT_decl_line>();
+	template <Dwarf_Half... CODES>
+	AttributeValues<CODES...> getAttributeValues() const
 	{
-		using ValueType = typename Attribute<CODE>::value_type;
-
-		Dwarf_Error err;
-		Dwarf_Attribute *attrs;
-		Dwarf_Signed attr_count;
+		if (tree != nullptr)
+		{
+			AttributeValues<CODES...> values(missingAttribute<CODES>("Failed to find matching DIE attribute")...);
+			const FlatDIE &record = (*tree)[index];
+			for (uint16_t i = 0; i < record.attribute_count; i++)
+			{
+				assignMatchingFlatValue<CODES...>(values, record.attributes[i],
+				                                  std::make_index_sequence<sizeof...(CODES)>{});
+			}
+			return values;
+		}
 
-		// Get the list of attributes and the list size
-		if (dwarf_attrlist(die, &attrs, &attr_count, &err) != DW_DLV_OK)
-			return make_unexpected("Failed to read DIE attributes");
+		AttributeList attrs(dbg, die);
+		if (!attrs.isValid())
+			return AttributeValues<CODES...>(missingAttribute<CODES>("Failed to read DIE attributes")...);
 
-		// Loop through all attributes
-		for (int i = 0; i < attr_count; i++)
+		AttributeValues<CODES...> values(missingAttribute<CODES>("Failed to find matching DIE attribute")...);
+		for (Dwarf_Signed i = 0; i < attrs.size(); i++)
 		{
-			if (Attribute<CODE>::isMatchingType(attrs[i]))
-				return Attribute<CODE>::value(attrs[i]);
+			Dwarf_Half code;
+			Dwarf_Error err;
+			if (dwarf_whatattr(attrs[i], &code, &err) != DW_DLV_OK)
+				continue;
+
+			assignMatchingValue<CODES...>(values, code, attrs[i],
+			                              std::make_index_sequence<sizeof...(CODES)>{});
 		}
-		return make_unexpected("Failed to find matching DIE attribute");
+		return values;
+	}
+
+	template <Dwarf_Half CODE>
+	AttributeValue<CODE> getAttributeValue() const
+	{
+		return std::get<0>(getAttributeValues<CODE>());
 	}
 
 	template <Dwarf_Half CODE>
 	bool hasAttribute() const
 	{
-		return getAttributeValue<CODE>().has_value();
+		if (tree != nullptr)
+			return tree->findAttribute(index, CODE) != nullptr;
+
+		Dwarf_Bool has_attr = false;
+		Dwarf_Error err;
+		return dwarf_hasattr(die, CODE, &has_attr, &err) == DW_DLV_OK && has_attr;
 	}
 
-	Dwarf_Off getCUOffset();
+	// Gets the form an attribute is encoded with, or 0 if it is not present
+	template <Dwarf_Half CODE>
+	Dwarf_Half getAttributeForm() const
+	{
+		if (tree != nullptr)
+		{
+			const FlatAttribute *attr = tree->findAttribute(index, CODE);
+			return (attr != nullptr ? attr->form : 0);
+		}
+
+		Dwarf_Attribute attr;
+		Dwarf_Half form = 0;
+		Dwarf_Error err;
+		if (dwarf_attr(die, CODE, &attr, &err) == DW_DLV_OK)
+		{
+			if (dwarf_whatform(attr, &form, &err) != DW_DLV_OK)
+				form = 0;
+			dwarf_dealloc(dbg, attr, DW_DLA_ATTR);
+		}
+		return form;
+	}
+
+	Dwarf_Off getCUOffset() const;
 	std::vector<DIE> getChildren();
+	std::vector<PCRange> getPCRanges() const;
+	Dwarf_Half getTag() const;
 	std::string getTagName() const;
-	Dwarf_Off getOffset();
+	Dwarf_Off getOffset() const;
 
+	// The libdwarf handles are only set for DIEs which are not in a DIETree
 	const Dwarf_Die &get() const;
+	const Dwarf_Debug &getDebug() const;
+
+	// The tree holding this DIE's record, which is null for DIEs read through
+	// libdwarf, and the index of the record within it
+	const DIETree *getTree() const;
+	uint32_t getTreeIndex() const;
 
 private:
 	Dwarf_Debug dbg;
 	Dwarf_Die die;
-	std::string tag_name;
+	Dwarf_Half tag;
 
-	void setTagName();
+	const DIETree *tree;
+	uint32_t index;
+
+	void setTag();
+	uint64_t getCUBaseAddress() const;
+
+	template <Dwarf_Half CODE>
+	static AttributeValue<CODE> missingAttribute(const char *reason)
+	{
+		return make_unexpected(std::string(reason));
+	}
+
+	template <Dwarf_Half... CODES, std::size_t... INDICES>
+	static void assignMatchingValue(AttributeValues<CODES...> &values, Dwarf_Half code,
+	                                const Dwarf_Attribute &attr,
+	                                std::index_sequence<INDICES...>)
+	{
+		((code == CODES ? (void)(std::get<INDICES>(values) = Attribute<CODES>::value(attr)) : (void)0), ...);
+	}
+
+	template <Dwarf_Half... CODES, std::size_t... INDICES>
+	void assignMatchingFlatValue(AttributeValues<CODES...> &values, const FlatAttribute &attr,
+	                             std::index_sequence<INDICES...>) const
+	{
+		((attr.code == CODES ?
+		  (void)(std::get<INDICES>(values) = tree->value<typename Attribute<CODES>::value_type>(attr)) :
+		  (void)0), ...);
+	}
 };
 
 class DIEMatcher
 {
 public:
-	DIEMatcher &setTags(const std::vector<std::string> &tags);
+	DIEMatcher &setTags(const std::vector<Dwarf_Half> &tags);
 	DIEMatcher &setAttrCodes(const std::vector<Dwarf_Half> &attr_codes);
+	// DIEs with these tags are matched as normal, but their children are not
+	// searched
+	DIEMatcher &setPrunedTags(const std::vector<Dwarf_Half> &pruned_tags);
 
 	bool matches(DIE &die);
+	bool shouldVisitChildren(DIE &die);
 
 private:
-	std::vector<std::string> tags;
+	std::vector<Dwarf_Half> tags;
+	std::vector<Dwarf_Half> pruned_tags;
 	std::vector<Dwarf_Half> attr_codes;
 };
 
@@ -0,0 +1,397 @@
+#include "DIETree.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "DIE.hpp"
+#include "DwarfReader.hpp"
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+// =============================================================================
+// Arena
+// =============================================================================
+
+Arena::Arena(size_t block_size) :
+	block_size(block_size),
+	block_used(0),
+	block_capacity(0),
+	reserved(0)
+{
+
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+	size_t offset = (block_used + alignment - 1) & ~(alignment - 1);
+	if (offset + size > block_capacity)
+	{
+		// Allocations larger than a block are given a block of their own
+		block_capacity = std::max(block_size, size);
+		blocks.push_back(std::make_unique<uint8_t[]>(block_capacity));
+		reserved += block_capacity;
+		offset = 0;
+	}
+	block_used = offset + size;
+	return blocks.back().get() + offset;
+}
+
+size_t Arena::capacity() const
+{
+	return reserved;
+}
+
+// =============================================================================
+// StringPool
+// =============================================================================
+
+uint32_t StringPool::intern(const char *str)
+{
+	auto it = ids.find(std::string_view(str));
+	if (it != ids.end())
+		return it->second;
+
+	size_t length = strlen(str);
+	char *copy = static_cast<char *>(arena.allocate(length + 1, 1));
+	memcpy(copy, str, length + 1);
+
+	uint32_t id = strings.size();
+	strings.push_back(copy);
+	ids.emplace(std::string_view(copy, length), id);
+	return id;
+}
+
+const char *StringPool::get(uint32_t id) const
+{
+	return strings[id];
+}
+
+size_t StringPool::size() const
+{
+	return strings.size();
+}
+
+size_t StringPool::capacity() const
+{
+	// The size of the hash table's nodes is an estimate, as it depends upon
+	// the standard library implementation
+	size_t node_size = sizeof(void *) + sizeof(std::pair<std::string_view, uint32_t>);
+	return arena.capacity() + strings.capacity() * sizeof(const char *) +
+	       ids.bucket_count() * sizeof(void *) + ids.size() * node_size;
+}
+
+// =============================================================================
+// DIETree
+// =============================================================================
+
+// Strings are either inline, or refer into one of the string sections, either
+// by offset or, in DWARF 5 and split units, by index through
+// .debug_str_offsets. libdwarf resolves all of them.
+static bool isStringForm(Dwarf_Half form)
+{
+	switch (form)
+	{
+	case DW_FORM_string:
+	case DW_FORM_strp:
+	case DW_FORM_line_strp:
+	case DW_FORM_strp_sup:
+	case DW_FORM_strx:
+	case DW_FORM_strx1:
+	case DW_FORM_strx2:
+	case DW_FORM_strx3:
+	case DW_FORM_strx4:
+	case DW_FORM_GNU_str_index:
+	case DW_FORM_GNU_strp_alt:
+		return true;
+	default:
+		return false;
+	}
+}
+
+size_t DIETree::MemoryUsage::total() const
+{
+	return records + attributes + strings;
+}
+
+DIETree::DIETree(DwarfInfoReader &reader)
+{
+	reader.visitDIEs([&](DIE &cu)
+	{
+		uint32_t index = decode(cu, NO_DIE);
+		compile_units.push_back(index);
+		decodeChildren(reader, cu, index);
+		return SKIP_CHILDREN;
+	});
+	dies.shrink_to_fit();
+
+	MemoryUsage usage = getMemoryUsage();
+	procmsg("[DWARF] Decoded %lu DIEs and %lu strings into %lu KiB (records: %lu KiB, "
+	        "attributes: %lu KiB, strings: %lu KiB)\n",
+	        dies.size(), strings.size(), usage.total() / 1024, usage.records / 1024,
+	        usage.attributes / 1024, usage.strings / 1024);
+}
+
+size_t DIETree::size() const
+{
+	return dies.size();
+}
+
+const FlatDIE &DIETree::operator[](uint32_t index) const
+{
+	return dies[index];
+}
+
+const std::vector<uint32_t> &DIETree::getCompileUnits() const
+{
+	return compile_units;
+}
+
+uint32_t DIETree::getCompileUnit(uint32_t index) const
+{
+	while (dies[index].parent != NO_DIE)
+		index = dies[index].parent;
+	return index;
+}
+
+uint32_t DIETree::findByOffset(Dwarf_Off offset) const
+{
+	auto it = std::lower_bound(dies.begin(), dies.end(), offset,
+	                           [](const FlatDIE &die, Dwarf_Off offset)
+	                           {
+	                               return die.offset < offset;
+	                           });
+	if (it == dies.end() || it->offset != offset)
+		return NO_DIE;
+	return it - dies.begin();
+}
+
+const FlatAttribute *DIETree::findAttribute(uint32_t index, Dwarf_Half code) const
+{
+	const FlatDIE &die = dies[index];
+	for (uint16_t i = 0; i < die.attribute_count; i++)
+	{
+		if (die.attributes[i].code == code)
+			return &die.attributes[i];
+	}
+	return nullptr;
+}
+
+std::vector<PCRange> DIETree::getPCRanges(uint32_t index) const
+{
+	// From DWARF4 onwards, the high PC may be encoded as an offset from the
+	// low PC
+	const FlatAttribute *low_pc = findAttribute(index, DW_AT_low_pc);
+	const FlatAttribute *high_pc = findAttribute(index, DW_AT_high_pc);
+	if (low_pc != nullptr && high_pc != nullptr)
+	{
+		uint64_t high = high_pc->value;
+		if (high_pc->form != DW_FORM_addr)
+			high += low_pc->value;
+		return {{low_pc->value, high}};
+	}
+
+	const FlatAttribute *ranges = findAttribute(index, DW_AT_ranges);
+	if (ranges == nullptr)
+		return {};
+
+	const PCRange *entries = reinterpret_cast<const PCRange *>(
+		reinterpret_cast<const uint8_t *>(ranges->value) + sizeof(Dwarf_Off));
+	return std::vector<PCRange>(entries, entries + ranges->length);
+}
+
+DIETree::MemoryUsage DIETree::getMemoryUsage() const
+{
+	MemoryUsage usage;
+	usage.records = dies.capacity() * sizeof(FlatDIE) + compile_units.capacity() * sizeof(uint32_t);
+	usage.attributes = arena.capacity();
+	usage.strings = strings.capacity();
+	return usage;
+}
+
+uint32_t DIETree::decode(DIE &die, uint32_t parent)
+{
+	FlatDIE record;
+	record.offset = die.getOffset();
+	record.parent = parent;
+	record.first_child = NO_DIE;
+	record.next_sibling = NO_DIE;
+	record.tag = die.getTag();
+	record.attributes = nullptr;
+	record.attribute_count = 0;
+
+	// Attributes which can't be decoded are left out, so the block may be
+	// larger than needed
+	AttributeList attrs(die.getDebug(), die.get());
+	if (attrs.size() > 0)
+	{
+		FlatAttribute *flat_attrs = static_cast<FlatAttribute *>(
+			arena.allocate(attrs.size() * sizeof(FlatAttribute), alignof(FlatAttribute)));
+		for (Dwarf_Signed i = 0; i < attrs.size(); i++)
+		{
+			if (decodeAttribute(die, attrs[i], flat_attrs[record.attribute_count]))
+				record.attribute_count++;
+		}
+		record.attributes = flat_attrs;
+	}
+
+	dies.push_back(record);
+	return dies.size() - 1;
+}
+
+void DIETree::decodeChildren(DwarfInfoReader &reader, DIE &die, uint32_t parent)
+{
+	uint32_t previous = NO_DIE;
+	reader.visitChildren(die, [&](DIE &child)
+	{
+		uint32_t index = decode(child, parent);
+		if (previous == NO_DIE)
+			dies[parent].first_child = index;
+		else
+			dies[previous].next_sibling = index;
+		previous = index;
+
+		decodeChildren(reader, child, index);
+		return SKIP_CHILDREN;
+	});
+}
+
+bool DIETree::decodeAttribute(const DIE &die, const Dwarf_Attribute &attr, FlatAttribute &flat_attr)
+{
+	Dwarf_Error err;
+	if (dwarf_whatattr(attr, &flat_attr.code, &err) != DW_DLV_OK ||
+	    dwarf_whatform(attr, &flat_attr.form, &err) != DW_DLV_OK)
+	{
+		return false;
+	}
+	flat_attr.length = 0;
+	flat_attr.value = 0;
+
+	// Range lists are resolved while libdwarf is available, as they depend
+	// upon the base address of the compilation unit
+	if (flat_attr.code == DW_AT_ranges)
+	{
+		Dwarf_Off offset = Attribute<DW_AT_ranges>::value(attr);
+		std::vector<PCRange> ranges = die.getPCRanges();
+		flat_attr.length = ranges.size();
+		flat_attr.value = copyBlock(ranges.data(), ranges.size() * sizeof(PCRange),
+		                            &offset, sizeof(offset));
+		return true;
+	}
+
+	if (isStringForm(flat_attr.form))
+	{
+		char *str;
+		if (dwarf_formstring(attr, &str, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = strings.intern(str);
+		return true;
+	}
+
+	switch (flat_attr.form)
+	{
+	case DW_FORM_addr:
+	{
+		Dwarf_Addr address;
+		if (dwarf_formaddr(attr, &address, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = address;
+		return true;
+	}
+	case DW_FORM_ref1:
+	case DW_FORM_ref2:
+	case DW_FORM_ref4:
+	case DW_FORM_ref8:
+	case DW_FORM_ref_udata:
+	case DW_FORM_ref_addr:
+	case DW_FORM_sec_offset:
+	{
+		Dwarf_Off offset;
+		if (dwarf_global_formref(attr, &offset, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = offset;
+		return true;
+	}
+	case DW_FORM_flag:
+	case DW_FORM_flag_present:
+	{
+		Dwarf_Bool flag;
+		if (dwarf_formflag(attr, &flag, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = flag;
+		return true;
+	}
+	case DW_FORM_sdata:
+	{
+		Dwarf_Signed data;
+		if (dwarf_formsdata(attr, &data, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = static_cast<uint64_t>(data);
+		return true;
+	}
+	case DW_FORM_exprloc:
+	{
+		Dwarf_Unsigned length;
+		Dwarf_Ptr data;
+		if (dwarf_formexprloc(attr, &length, &data, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.length = length;
+		flat_attr.value = copyBlock(data, length, nullptr, 0);
+		return true;
+	}
+	case DW_FORM_block:
+	case DW_FORM_block1:
+	case DW_FORM_block2:
+	case DW_FORM_block4:
+	{
+		Dwarf_Block *block;
+		if (dwarf_formblock(attr, &block, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.length = block->bl_len;
+		flat_attr.value = copyBlock(block->bl_data, block->bl_len, nullptr, 0);
+		dwarf_dealloc(die.getDebug(), block, DW_DLA_BLOCK);
+		return true;
+	}
+	default:
+	{
+		// The remaining forms are constants
+		Dwarf_Unsigned data;
+		if (dwarf_formudata(attr, &data, &err) != DW_DLV_OK)
+			return false;
+		flat_attr.value = data;
+		return true;
+	}
+	}
+}
+
+uint64_t DIETree::copyBlock(const void *data, size_t size, const void *header, size_t header_size)
+{
+	uint8_t *copy = static_cast<uint8_t *>(arena.allocate(header_size + size, alignof(uint64_t)));
+	if (header_size > 0)
+		memcpy(copy, header, header_size);
+	if (size > 0)
+		memcpy(copy + header_size, data, size);
+	return reinterpret_cast<uint64_t>(copy);
+}
+
+void DIETree::convert(const FlatAttribute &attr, char *&result) const
+{
+	result = isStringForm(attr.form) ? const_cast<char *>(strings.get(attr.value)) : nullptr;
+}
+
+void DIETree::convert(const FlatAttribute &attr, Dwarf_Unsigned &result) const
+{
+	if (attr.code == DW_AT_ranges)
+		memcpy(&result, reinterpret_cast<const void *>(attr.value), sizeof(Dwarf_Off));
+	else
+		result = attr.value;
+}
+
+void DIETree::convert(const FlatAttribute &attr, ExprLoc &result) const
+{
+	bool is_block = (attr.form == DW_FORM_exprloc || attr.form == DW_FORM_block ||
+	                 attr.form == DW_FORM_block1 || attr.form == DW_FORM_block2 ||
+	                 attr.form == DW_FORM_block4);
+	result.length = is_block ? attr.length : 0;
+	result.ptr = is_block ? reinterpret_cast<Dwarf_Ptr>(attr.value) : nullptr;
+}
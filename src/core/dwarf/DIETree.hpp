@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+#include <libdwarf/dwarf.h>
+
+#include "Attribute.hpp"
+
+class DIE;
+class DwarfInfoReader;
+
+// Bump allocator for data which lives as long as its owner. Memory is handed
+// out from large blocks and is only released when the arena is destroyed.
+class Arena
+{
+public:
+	Arena(size_t block_size = 1 << 20);
+
+	Arena(const Arena &other) = delete;
+	Arena &operator=(const Arena &other) = delete;
+
+	void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	// The number of bytes reserved by the arena, including unused space
+	size_t capacity() const;
+
+private:
+	size_t block_size;
+	std::vector<std::unique_ptr<uint8_t[]>> blocks;
+	size_t block_used;
+	size_t block_capacity;
+	size_t reserved;
+};
+
+// Stores a single copy of each distinct string, referred to by a 32-bit id
+class StringPool
+{
+public:
+	uint32_t intern(const char *str);
+	const char *get(uint32_t id) const;
+
+	size_t size() const;
+	size_t capacity() const;
+
+private:
+	Arena arena;
+	std::vector<const char *> strings;
+	std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// A decoded attribute. The meaning of the value depends upon the form:
+// - Strings hold an id in the tree's string pool.
+// - References hold a .debug_info offset.
+// - Blocks and expressions point to length bytes copied into the arena.
+// - DW_AT_ranges points to its .debug_ranges offset, followed by length
+//   resolved PCRange entries.
+// - Anything else holds the constant, address or flag itself.
+struct FlatAttribute
+{
+	Dwarf_Half code;
+	Dwarf_Half form;
+	uint32_t length;
+	uint64_t value;
+};
+
+// A compact DIE record. Records are stored in .debug_info order, so that the
+// children of a DIE always follow it.
+struct FlatDIE
+{
+	Dwarf_Off offset;
+	const FlatAttribute *attributes;
+	uint32_t parent;
+	uint32_t first_child;
+	uint32_t next_sibling;
+	Dwarf_Half tag;
+	uint16_t attribute_count;
+};
+
+// Fully decoded copy of .debug_info, built with a single pass over every
+// compilation unit. Once built, it can be queried without calling into
+// libdwarf.
+class DIETree
+{
+public:
+	static constexpr uint32_t NO_DIE = UINT32_MAX;
+
+	struct MemoryUsage
+	{
+		size_t records;
+		size_t attributes;
+		size_t strings;
+
+		size_t total() const;
+	};
+
+	DIETree(DwarfInfoReader &reader);
+
+	DIETree(const DIETree &other) = delete;
+	DIETree &operator=(const DIETree &other) = delete;
+
+	size_t size() const;
+	const FlatDIE &operator[](uint32_t index) const;
+
+	const std::vector<uint32_t> &getCompileUnits() const;
+	uint32_t getCompileUnit(uint32_t index) const;
+	uint32_t findByOffset(Dwarf_Off offset) const;
+
+	const FlatAttribute *findAttribute(uint32_t index, Dwarf_Half code) const;
+	std::vector<PCRange> getPCRanges(uint32_t index) const;
+
+	// Converts an attribute to the value type of its Attribute<CODE>
+	template <typename T>
+	T value(const FlatAttribute &attr) const
+	{
+		T result;
+		convert(attr, result);
+		return result;
+	}
+
+	MemoryUsage getMemoryUsage() const;
+
+private:
+	std::vector<FlatDIE> dies;
+	std::vector<uint32_t> compile_units;
+	Arena arena;
+	StringPool strings;
+
+	uint32_t decode(DIE &die, uint32_t parent);
+	void decodeChildren(DwarfInfoReader &reader, DIE &die, uint32_t parent);
+	bool decodeAttribute(const DIE &die, const Dwarf_Attribute &attr, FlatAttribute &flat_attr);
+	uint64_t copyBlock(const void *data, size_t size, const void *header, size_t header_size);
+
+	void convert(const FlatAttribute &attr, char *&result) const;
+	void convert(const FlatAttribute &attr, Dwarf_Unsigned &result) const;
+	void convert(const FlatAttribute &attr, ExprLoc &result) const;
+};
@@ -1,9 +1,84 @@
 #include "DebugAddressRanges.hpp"
 
+#include <algorithm>
+#include <unordered_set>
+
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
 
-DebugAddressRanges::DebugAddressRanges(const Dwarf_Debug &dbg)
+DebugAddressRanges::DebugAddressRanges(const Dwarf_Debug &dbg,
+                                       const std::vector<DIE> &compile_units)
+{
+	std::vector<IntervalMap<Dwarf_Off>::Interval> ranges;
+	readAranges(dbg, ranges);
+
+	// Fall back to the DW_AT_low_pc/DW_AT_high_pc or DW_AT_ranges attributes
+	// of any compilation unit that .debug_aranges doesn't describe
+	std::unordered_set<Dwarf_Off> described_cus;
+	for (const auto &range : ranges)
+		described_cus.insert(range.value);
+
+	size_t fallback_count = 0;
+	for (const auto &cu : compile_units)
+	{
+		Dwarf_Off cu_offset = cu.getOffset();
+		if (described_cus.count(cu_offset) > 0)
+			continue;
+
+		for (const auto &pc_range : cu.getPCRanges())
+		{
+			if (pc_range.low_pc < pc_range.high_pc)
+				ranges.push_back({pc_range.low_pc, pc_range.high_pc, cu_offset});
+		}
+		fallback_count++;
+	}
+
+	// Merge adjacent and overlapping ranges belonging to the same compilation
+	// unit to keep the table small
+	std::sort(ranges.begin(), ranges.end(),
+	          [](const IntervalMap<Dwarf_Off>::Interval &a, const IntervalMap<Dwarf_Off>::Interval &b)
+	          {
+	              return a.low < b.low;
+	          });
+
+	std::vector<IntervalMap<Dwarf_Off>::Interval> merged;
+	for (const auto &range : ranges)
+	{
+		if (!merged.empty() && merged.back().value == range.value &&
+		    range.low <= merged.back().high)
+		{
+			merged.back().high = std::max(merged.back().high, range.high);
+		}
+		else
+		{
+			merged.push_back(range);
+		}
+	}
+	address_ranges = IntervalMap<Dwarf_Off>(std::move(merged));
+
+	procmsg("[DWARF] %lu address ranges for %lu compilation units (%lu without aranges)\n",
+	        address_ranges.size(), compile_units.size(), fallback_count);
+}
+
+expected<Dwarf_Off, std::string> DebugAddressRanges::getCompileUnitOffset(uint64_t address) const
+{
+	const Dwarf_Off *cu_offset = address_ranges.find(address);
+	if (cu_offset != nullptr)
+		return *cu_offset;
+	else
+		return make_unexpected("Failed to find compilation unit at address: " + std::to_string(address));
+}
+
+std::vector<AddressRange> DebugAddressRanges::getAddressRanges() const
+{
+	std::vector<AddressRange> ranges;
+	for (const auto &interval : address_ranges.getIntervals())
+		ranges.emplace_back(interval.low, interval.high, interval.value);
+	return ranges;
+}
+
+void DebugAddressRanges::readAranges(const Dwarf_Debug &dbg,
+                                     std::vector<IntervalMap<Dwarf_Off>::Interval> &ranges)
 {
 	Dwarf_Arange *aranges;
 	Dwarf_Signed arange_count;
@@ -23,6 +98,7 @@ DebugAddressRanges::DebugAddressRanges(const Dwarf_Debug &dbg)
 	}
 
 	// Loop through all aranges
+	ranges.reserve(arange_count);
 	for (int i = 0; i < arange_count; i++)
 	{
 		Dwarf_Addr start;
@@ -37,22 +113,11 @@ DebugAddressRanges::DebugAddressRanges(const Dwarf_Debug &dbg)
 				&cu_die_offset,
 				&err);
 		if (result == DW_DLV_ERROR)
-		{
 			procmsg("[DWARF_ERROR] Error in dwarf_get_arange_info!\n");
-			return;
-		}
+		else if (length > 0)
+			ranges.push_back({start, start + length, cu_die_offset});
 
-		// Create the address range and push it to the vector
-		AddressRange range(start, start + length, length);
-		address_ranges.push_back(range);
-
-		// DEBUG
-		procmsg("[DWARF] ========== ADDRESS RANGE ==========\n");
-		procmsg("[DWARF] Start: %lx End: %lx Length: %lx\n", start, start + length, length);
+		dwarf_dealloc(dbg, aranges[i], DW_DLA_ARANGE);
 	}
+	dwarf_dealloc(dbg, aranges, DW_DLA_LIST);
 }
-
-std::vector<AddressRange> DebugAddressRanges::getAddressRanges()
-{
-	return address_ranges;
-}
\ No newline at end of file
@@ -1,33 +1,49 @@
 #pragma once
 
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include <libdwarf/libdwarf.h>
 #include <libdwarf/dwarf.h>
 
+#include "../expected.hpp"
+
+#include "DIE.hpp"
+#include "IntervalMap.hpp"
+
+using namespace nonstd;
+
 struct AddressRange
 {
-	AddressRange(uint64_t start, uint64_t end, uint64_t length) :
+	AddressRange(uint64_t start, uint64_t end, Dwarf_Off cu_offset) :
 		start(start),
 		end(end),
-		length(length) {}
+		length(end - start),
+		cu_offset(cu_offset) {}
 
 	const uint64_t start;
 	const uint64_t end;
 	const uint64_t length;
+	const Dwarf_Off cu_offset;
 };
 
 // Lookup table for mapping addresses to compilation units.
 // Represents the information presented when performing a call to
-// objdump --dwarf=aranges.
+// objdump --dwarf=aranges. Compilation units which are not described by
+// .debug_aranges (or all of them, if the section is missing) are added using
+// the address ranges of their DIEs instead.
 class DebugAddressRanges
 {
 public:
-	DebugAddressRanges(const Dwarf_Debug &dbg);
+	DebugAddressRanges(const Dwarf_Debug &dbg, const std::vector<DIE> &compile_units);
 
-	std::vector<AddressRange> getAddressRanges();
+	expected<Dwarf_Off, std::string> getCompileUnitOffset(uint64_t address) const;
+	std::vector<AddressRange> getAddressRanges() const;
 
 private:
-	std::vector<AddressRange> address_ranges;
-};
\ No newline at end of file
+	IntervalMap<Dwarf_Off> address_ranges;
+
+	void readAranges(const Dwarf_Debug &dbg,
+	                 std::vector<IntervalMap<Dwarf_Off>::Interval> &ranges);
+};
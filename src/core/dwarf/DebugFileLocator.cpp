@@ -0,0 +1,199 @@
+#include "DebugFileLocator.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <zlib.h>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+static bool isReadable(const std::string &path)
+{
+	return !path.empty() && access(path.c_str(), R_OK) == 0;
+}
+
+static std::string directoryOf(const std::string &path)
+{
+	size_t separator = path.find_last_of('/');
+	if (separator == std::string::npos)
+		return ".";
+	return separator == 0 ? "/" : path.substr(0, separator);
+}
+
+static std::string absolutePath(const std::string &path)
+{
+	char resolved[PATH_MAX];
+	if (realpath(path.c_str(), resolved) == nullptr)
+		return path;
+	return resolved;
+}
+
+// zlib takes 32-bit lengths, so large files are checked in pieces
+static uint32_t fileCrc(const ByteSpan &image)
+{
+	const size_t piece_size = 1 << 30;
+	uLong crc = crc32(0, Z_NULL, 0);
+	for (size_t offset = 0; offset < image.size; offset += piece_size)
+		crc = crc32(crc, image.data + offset, std::min(piece_size, image.size - offset));
+	return crc;
+}
+
+DebugFileLocator::DebugFileLocator(std::vector<std::string> debug_directories) :
+	debug_directories(std::move(debug_directories))
+{
+}
+
+std::vector<std::string> DebugFileLocator::defaultDirectories()
+{
+	const char *directories = getenv("VDB_DEBUG_FILE_DIRECTORY");
+	if (directories == nullptr || directories[0] == '\0')
+		return {"/usr/lib/debug"};
+
+	std::vector<std::string> result;
+	std::string list = directories;
+	size_t start = 0;
+	while (start <= list.size())
+	{
+		size_t end = list.find(':', start);
+		if (end == std::string::npos)
+			end = list.size();
+		if (end > start)
+			result.push_back(list.substr(start, end - start));
+		start = end + 1;
+	}
+	return result;
+}
+
+// Stripped executables have no .debug_info section, while the debug files of
+// stripped executables keep their headers but have no contents for any of the
+// other sections
+bool DebugFileLocator::hasDebugInfo(const ELFFile &elf_file)
+{
+	for (const auto &section : elf_file.sections())
+	{
+		if ((section.name == ".debug_info" || section.name == ".zdebug_info") && section.data.size > 0)
+			return true;
+	}
+	return false;
+}
+
+std::shared_ptr<ELFFile> DebugFileLocator::locate(std::shared_ptr<ELFFile> executable) const
+{
+	if (hasDebugInfo(*executable))
+		return executable;
+
+	std::shared_ptr<ELFFile> debug_file = locateByBuildId(*executable);
+	if (debug_file == nullptr)
+		debug_file = locateByDebugLink(*executable);
+	if (debug_file == nullptr)
+	{
+		procmsg("[DWARF_ERROR] No debugging information found for %s!\n", executable->filePath().c_str());
+		return executable;
+	}
+
+	procmsg("[DWARF] Reading debugging information from %s\n", debug_file->filePath().c_str());
+	return debug_file;
+}
+
+std::string DebugFileLocator::locateSplitUnit(const ELFFile &executable, const std::string &dwo_name,
+                                              const std::string &comp_dir) const
+{
+	// A package holds every split unit of the executable, and is preferred
+	// over the .dwo files it was made from
+	std::string package_path = executable.filePath() + ".dwp";
+	if (isReadable(package_path))
+		return package_path;
+
+	if (!dwo_name.empty() && dwo_name[0] == '/')
+		return isReadable(dwo_name) ? dwo_name : "";
+
+	std::string dwo_path = comp_dir + "/" + dwo_name;
+	if (isReadable(dwo_path))
+		return dwo_path;
+
+	// The executable may have been moved from where it was built along with
+	// its .dwo files
+	size_t separator = dwo_name.find_last_of('/');
+	std::string base_name = (separator == std::string::npos) ? dwo_name : dwo_name.substr(separator + 1);
+	dwo_path = directoryOf(executable.filePath()) + "/" + base_name;
+	return isReadable(dwo_path) ? dwo_path : "";
+}
+
+std::shared_ptr<ELFFile> DebugFileLocator::locateByBuildId(const ELFFile &executable) const
+{
+	auto build_id = executable.buildId();
+	if (!build_id || build_id.value().size() < 4)
+		return nullptr;
+
+	// The first byte of the ID names a subdirectory, so that no directory
+	// holds too many files
+	const std::string &id = build_id.value();
+	for (const auto &directory : debug_directories)
+	{
+		std::string path = directory + "/.build-id/" + id.substr(0, 2) + "/" + id.substr(2) + ".debug";
+		if (!isReadable(path))
+			continue;
+
+		// Candidates may be placeholders or truncated downloads
+		auto debug_file = ELFFile::open(path);
+		if (!debug_file)
+		{
+			procmsg("[DWARF_ERROR] Skipping debug file candidate: %s\n", debug_file.error().c_str());
+			continue;
+		}
+
+		auto debug_build_id = debug_file.value()->buildId();
+		if (debug_build_id && debug_build_id.value() == id && hasDebugInfo(*debug_file.value()))
+			return debug_file.value();
+	}
+	return nullptr;
+}
+
+std::shared_ptr<ELFFile> DebugFileLocator::locateByDebugLink(const ELFFile &executable) const
+{
+	// The section holds the name of the debug file, padded to four bytes,
+	// followed by the CRC-32 of the file's contents
+	auto debug_link = executable.sectionData(".gnu_debuglink");
+	if (!debug_link)
+		return nullptr;
+
+	const ByteSpan &data = debug_link.value();
+	const char *name = reinterpret_cast<const char *>(data.data);
+	size_t name_length = strnlen(name, data.size);
+	size_t crc_offset = (name_length + 4) & ~static_cast<size_t>(3);
+	if (name_length == 0 || crc_offset + sizeof(uint32_t) > data.size)
+		return nullptr;
+	std::string link_name(name, name_length);
+	uint32_t crc;
+	memcpy(&crc, data.data + crc_offset, sizeof(crc));
+
+	std::string executable_directory = directoryOf(absolutePath(executable.filePath()));
+	std::vector<std::string> candidates = {
+		executable_directory + "/" + link_name,
+		executable_directory + "/.debug/" + link_name
+	};
+	for (const auto &directory : debug_directories)
+		candidates.push_back(directory + executable_directory + "/" + link_name);
+
+	for (const auto &path : candidates)
+	{
+		// The link may name the executable itself
+		if (!isReadable(path) || absolutePath(path) == absolutePath(executable.filePath()))
+			continue;
+
+		auto debug_file = ELFFile::open(path);
+		if (!debug_file)
+		{
+			procmsg("[DWARF_ERROR] Skipping debug file candidate: %s\n", debug_file.error().c_str());
+			continue;
+		}
+
+		if (fileCrc(debug_file.value()->image()) == crc && hasDebugInfo(*debug_file.value()))
+			return debug_file.value();
+	}
+	return nullptr;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../ELFFile.hpp"
+
+// Finds debugging information which has been detached from an executable,
+// following the same conventions as GDB:
+// - Stripped executables are paired with a debug file named after their build
+//   ID (<debug dir>/.build-id/ab/cdef....debug), or the file named by their
+//   .gnu_debuglink section, which is checked against the CRC it records.
+// - Compilation units built with -gsplit-dwarf keep their DIEs in a .dwo file
+//   named by their skeleton, or in a .dwp package next to the executable.
+class DebugFileLocator
+{
+public:
+	DebugFileLocator(std::vector<std::string> debug_directories = defaultDirectories());
+
+	// $VDB_DEBUG_FILE_DIRECTORY (a colon separated list), or /usr/lib/debug
+	static std::vector<std::string> defaultDirectories();
+
+	// Gets the file holding an executable's DWARF, which is the executable
+	// itself unless it has been stripped and a debug file can be found
+	std::shared_ptr<ELFFile> locate(std::shared_ptr<ELFFile> executable) const;
+
+	// Whether a file has DWARF of its own
+	static bool hasDebugInfo(const ELFFile &elf_file);
+
+	// Gets the path of the file holding a split compilation unit, or an empty
+	// string if there isn't one
+	std::string locateSplitUnit(const ELFFile &executable, const std::string &dwo_name,
+	                            const std::string &comp_dir) const;
+
+private:
+	std::vector<std::string> debug_directories;
+
+	std::shared_ptr<ELFFile> locateByBuildId(const ELFFile &executable) const;
+	std::shared_ptr<ELFFile> locateByDebugLink(const ELFFile &executable) const;
+};
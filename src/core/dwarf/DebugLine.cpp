@@ -1,95 +1,180 @@
 #include "DebugLine.hpp"
 
+#include <algorithm>
+
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
 
-DebugLine::DebugLine(const std::vector<DIE> &compile_units) :
-	compile_units(compile_units)
+DebugLine::DebugLine(const Dwarf_Debug &dbg, const std::vector<DIE> &compile_units,
+                     std::shared_ptr<DebugAddressRanges> address_ranges,
+                     std::shared_ptr<SourcePathTable> source_paths) :
+	dbg(dbg),
+	compile_units(compile_units),
+	address_ranges(address_ranges),
+	source_paths(source_paths)
 {
-
+	for (size_t i = 0; i < compile_units.size(); i++)
+		compile_units_by_offset.emplace(compile_units[i].getOffset(), i);
 }
 
-// std::optional<Line> DebugLine::getLine(uint64_t address)
-// {
-// 	DIE compile_unit = getCompileUnit(address);
-// 	std::vector<Line> lines = generateLineInfo(compile_unit, address, address + 1);
-// 	return (lines.empty() ? std::nullopt : std::make_optional<Line>(lines.at(0)));
-// }
+void DebugLine::setLineTable(Dwarf_Off cu_offset, std::unique_ptr<LineTable> table)
+{
+	std::unique_ptr<Lines> lines = internLines(*table);
+
+	// An existing table is kept, as views of it may have been handed out
+	std::lock_guard<std::mutex> lock(line_tables_mtx);
+	line_tables.emplace(cu_offset, std::move(lines));
+}
 
-std::vector<Line> DebugLine::getFunctionLines(uint64_t address)
+expected<SourceLine, std::string> DebugLine::getLine(uint64_t address)
 {
 	auto cu_expected = getCompileUnit(address);
 	if (!cu_expected)
-		return {};
+		return make_unexpected(cu_expected.error());
 
-	DIE compile_unit = cu_expected.value();
-	std::vector<DIE> children = compile_unit.getChildren();
-	while (!children.empty())
-	{
-		// Examine all this child's children
-		std::vector<DIE> subchildren = children.front().getChildren();
-		children.insert(children.end(), subchildren.begin(), subchildren.end());
+	const Lines &lines = getLines(cu_expected.value());
 
-		// If the child is a subprogram
-		if (children.front().getTagName() == "DW_TAG_subprogram")
-		{
-			// If the subprogram has address range information
-			auto low_pc_opt = children.front().getAttributeValue<DW_AT_low_pc>();
-			auto high_pc_opt = children.front().getAttributeValue<DW_AT_high_pc>();
-			if (low_pc_opt.has_value() && high_pc_opt.has_value())
-			{
-				// Check if the address is within this function's range
-				Dwarf_Addr low_pc = low_pc_opt.value();
-				Dwarf_Off high_pc = high_pc_opt.value();
-				if (address >= low_pc && address < (low_pc + high_pc))
-				{
-					std::vector<Line> func_lines = generateLineInfo(compile_unit,
-					                                                low_pc,
-					                                                (low_pc + high_pc));
-					return func_lines;
-				}
-			}
-		}
+	// Find the last row at or before the address
+	auto it = std::upper_bound(lines.rows.begin(), lines.rows.end(), address,
+	                           [](uint64_t address, const SourceLine &row)
+	                           {
+	                               return address < row.address;
+	                           });
+	if (it == lines.rows.begin())
+		return make_unexpected("No line information at address: " + std::to_string(address));
+	--it;
 
-		children.erase(children.begin());
-	}
-	return {};
+	// An end of sequence marks the first address after the sequence, so if
+	// one lies between the row and the address, the address must lie in a gap
+	// between sequences
+	auto end_it = std::upper_bound(lines.sequence_ends.begin(), lines.sequence_ends.end(), it->address);
+	if (end_it != lines.sequence_ends.end() && *end_it <= address)
+		return make_unexpected("No line information at address: " + std::to_string(address));
+
+	// When several rows share an address, the first one in the line number
+	// program describes the instruction
+	while (it != lines.rows.begin() && (it - 1)->address == it->address)
+		--it;
+
+	return *it;
 }
 
-std::vector<Line> DebugLine::getCULines(uint64_t address)
+Span<SourceLine> DebugLine::getAddressRangeLines(uint64_t start_address, uint64_t end_address)
 {
-	auto cu_expected = getCompileUnit(address);
+	auto cu_expected = getCompileUnit(start_address);
 	if (!cu_expected)
-		return generateLineInfo(cu_expected.value());
+		return {};
+
+	const Lines &lines = getLines(cu_expected.value());
+
+	auto compare = [](const SourceLine &row, uint64_t address)
+	{
+		return row.address < address;
+	};
+	auto begin = std::lower_bound(lines.rows.begin(), lines.rows.end(), start_address, compare);
+	auto end = std::lower_bound(begin, lines.rows.end(), end_address, compare);
+	return Span<SourceLine>(lines.rows.data() + (begin - lines.rows.begin()), end - begin);
+}
+
+Span<SourceLine> DebugLine::getCULines(uint64_t address)
+{
+	auto cu_expected = getCompileUnit(address);
+	if (cu_expected)
+		return getCULines(cu_expected.value());
 	else
 		return {};
 }
 
-std::vector<Line> DebugLine::getCULines(const DIE &compile_unit)
+Span<SourceLine> DebugLine::getCULines(const DIE &compile_unit)
 {
-	return generateLineInfo(compile_unit);
+	const Lines &lines = getLines(compile_unit);
+	return Span<SourceLine>(lines.rows.data(), lines.rows.size());
 }
 
 expected<DIE, std::string> DebugLine::getCompileUnit(uint64_t address)
 {
-	for (const auto& cu : compile_units)
+	auto expected_cu_offset = address_ranges->getCompileUnitOffset(address);
+	if (!expected_cu_offset)
+		return make_unexpected(expected_cu_offset.error());
+
+	auto it = compile_units_by_offset.find(expected_cu_offset.value());
+	if (it == compile_units_by_offset.end())
+		return make_unexpected("Unknown compilation unit at address: " + std::to_string(address));
+	return compile_units[it->second];
+}
+
+const DebugLine::Lines &DebugLine::getLines(const DIE &compile_unit)
+{
+	std::lock_guard<std::mutex> lock(line_tables_mtx);
+
+	// Tables are never evicted, so views of them remain valid
+	Dwarf_Off offset = compile_unit.getOffset();
+	auto it = line_tables.find(offset);
+	if (it == line_tables.end())
+		it = line_tables.emplace(offset, internLines(*decodeLineTable(dbg, compile_unit))).first;
+	return *(it->second);
+}
+
+std::unique_ptr<DebugLine::Lines> DebugLine::internLines(const LineTable &table)
+{
+	std::vector<uint32_t> file_ids;
+	file_ids.reserve(table.files.size());
+	for (const auto &file : table.files)
+		file_ids.push_back(source_paths->intern(file));
+
+	// The table is already sorted, and stays sorted with the sequence ends
+	// taken out
+	auto lines = std::make_unique<Lines>();
+	lines->rows.reserve(table.rows.size());
+	for (const auto &row : table.rows)
 	{
-		auto expected_low_pc = cu.getAttributeValue<DW_AT_low_pc>();
-		auto expected_high_pc = cu.getAttributeValue<DW_AT_high_pc>();
-		if (!expected_low_pc || !expected_high_pc)
-			continue;
-
-		Dwarf_Addr low_pc = expected_low_pc.value();
-		Dwarf_Off high_pc = expected_high_pc.value();
-		if (address >= low_pc && address < (low_pc + high_pc))
-			return cu;
+		if (row.is_end_sequence)
+			lines->sequence_ends.push_back(row.address);
+		else
+		{
+			// Rows read from a damaged cache may name files the table lacks
+			uint32_t file = (row.file < file_ids.size()) ? file_ids[row.file] :
+			                source_paths->intern("<file_name_not_found>");
+			lines->rows.push_back(SourceLine{row.address, row.line, file});
+		}
 	}
-	return make_unexpected("Failed to find compilation unit at address: " + std::to_string(address));
+	lines->rows.shrink_to_fit();
+	return lines;
+}
+
+expected<std::string, std::string> DebugLine::getPrimarySourceFile(const Dwarf_Debug &dbg,
+                                                                  const DIE &compile_unit)
+{
+	std::string error = "No line table for compilation unit at offset: " +
+	                    std::to_string(compile_unit.getOffset());
+
+	Dwarf_Error err;
+	Dwarf_Die cu_die = compile_unit.get();
+	bool is_flat = (compile_unit.getTree() != nullptr);
+	if (is_flat && dwarf_offdie(dbg, compile_unit.getOffset(), &cu_die, &err) != DW_DLV_OK)
+		return make_unexpected(error);
+
+	// Only the header of the line table is read
+	char **files = nullptr;
+	Dwarf_Signed file_count = 0;
+	int result = dwarf_srcfiles(cu_die, &files, &file_count, &err);
+	if (is_flat)
+		dwarf_dealloc(dbg, cu_die, DW_DLA_DIE);
+	if (result != DW_DLV_OK)
+		return make_unexpected(error);
+
+	std::string primary_file = (file_count > 0 ? files[0] : "");
+	for (Dwarf_Signed i = 0; i < file_count; i++)
+		dwarf_dealloc(dbg, files[i], DW_DLA_STRING);
+	dwarf_dealloc(dbg, files, DW_DLA_LIST);
+
+	if (primary_file.empty())
+		return make_unexpected(error);
+	return primary_file;
 }
 
-std::vector<Line> DebugLine::generateLineInfo(const DIE &compile_unit,
-                                              uint64_t start_address,
-                                              uint64_t end_address)
+std::unique_ptr<LineTable> DebugLine::decodeLineTable(const Dwarf_Debug &dbg,
+                                                      const DIE &compile_unit)
 {
 	/*
 	TODO:
@@ -98,62 +183,114 @@ std::vector<Line> DebugLine::generateLineInfo(const DIE &compile_unit,
 	implemented as well.
 	*/
 
-	std::vector<Line> lines;
+	auto table = std::make_unique<LineTable>();
 
 	Dwarf_Line *line_buffer = nullptr;
 	Dwarf_Signed line_count = 0;
 	Dwarf_Error err;
 
+	// Compilation units read from a DIETree have no libdwarf handle of their
+	// own, so one is looked up while decoding
+	Dwarf_Die cu_die = compile_unit.get();
+	bool is_flat = (compile_unit.getTree() != nullptr);
+	if (is_flat && dwarf_offdie(dbg, compile_unit.getOffset(), &cu_die, &err) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Error in dwarf_offdie!\n");
+		return table;
+	}
+
 	// Get the source lines from the specified compilation unit
 	int result = dwarf_srclines(
-		compile_unit.get(),
+		cu_die,
 		&line_buffer,
 		&line_count,
 		&err);
 
-	if (result == DW_DLV_OK)
+	if (is_flat)
+		dwarf_dealloc(dbg, cu_die, DW_DLA_DIE);
+
+	if (result != DW_DLV_OK)
 	{
-		for (int i = 0; i < line_count; i++)
+		procmsg("[DWARF_ERROR] Error in dwarf_srclines!\n");
+		return table;
+	}
+
+	// Maps the line program's file numbers to indices in the table's files
+	std::unordered_map<Dwarf_Unsigned, uint16_t> file_indices;
+
+	table->rows.reserve(line_count);
+	for (int i = 0; i < line_count; i++)
+	{
+		LineTable::Row row;
+
+		// Get the line address
+		Dwarf_Addr line_addr;
+		result = dwarf_lineaddr(line_buffer[i], &line_addr, &err);
+		if (result != DW_DLV_OK)
+			procmsg("[DWARF_ERROR] Error in dwarf_lineaddr!\n");
+		row.address = line_addr;
+
+		// Get the line number
+		Dwarf_Unsigned line_number;
+		result = dwarf_lineno(line_buffer[i], &line_number, &err);
+		if (result != DW_DLV_OK)
+			procmsg("[DWARF_ERROR] Error in dwarf_lineno!\n");
+		row.line = line_number;
+
+		// Determine whether it is the beginning statement or not
+		Dwarf_Bool is_begin_statement;
+		result = dwarf_linebeginstatement(line_buffer[i], &is_begin_statement, &err);
+		if (result != DW_DLV_OK)
+			procmsg("[DWARF_ERROR] Error in dwarf_linebeginstatement!\n");
+		row.is_begin_statement = is_begin_statement;
+
+		// Determine whether the row terminates a sequence of addresses
+		Dwarf_Bool is_end_sequence;
+		result = dwarf_lineendsequence(line_buffer[i], &is_end_sequence, &err);
+		if (result != DW_DLV_OK)
+			procmsg("[DWARF_ERROR] Error in dwarf_lineendsequence!\n");
+		row.is_end_sequence = is_end_sequence;
+
+		// Get the source file the line came from. Each distinct file name is
+		// only read and stored once per table.
+		Dwarf_Unsigned file_number;
+		result = dwarf_line_srcfileno(line_buffer[i], &file_number, &err);
+		if (result != DW_DLV_OK)
+			procmsg("[DWARF_ERROR] Error in dwarf_line_srcfileno!\n");
+
+		auto file_it = file_indices.find(file_number);
+		if (file_it == file_indices.end())
 		{
-			Dwarf_Error err;
-
-			// Get the line address
-			Dwarf_Addr line_addr;
-			result = dwarf_lineaddr(line_buffer[i], &line_addr, &err);
-			if (result != DW_DLV_OK)
-				procmsg("[DWARF_ERROR] Error in dwarf_lineaddr!\n");
-
-			// Only include the line entries which are within the specified
-			// address range
-			if (start_address > 0 && end_address > 0)
-				if (line_addr < start_address || line_addr >= end_address)
-					continue;
-
-			// Get the line number
-			Dwarf_Unsigned line_number;
-			int result = dwarf_lineno(line_buffer[i], &line_number, &err);
-			if (result != DW_DLV_OK)
-				procmsg("[DWARF_ERROR] Error in dwarf_lineno!\n");
-
-			// Determine whether it is the beginning statement or not
-			Dwarf_Bool is_begin_statement;
-			result = dwarf_linebeginstatement(line_buffer[i], &is_begin_statement, &err);
-			if (result != DW_DLV_OK)
-				procmsg("[DWARF_ERROR] Error in dwarf_linebeginstatement!\n");
-
-			// Get the source file the line came from
 			char *line_src;
-			dwarf_linesrc(line_buffer[i], &line_src, &err);
-			if (result != DW_DLV_OK)
+			result = dwarf_linesrc(line_buffer[i], &line_src, &err);
+			if (result == DW_DLV_OK)
+			{
+				table->files.emplace_back(line_src);
+				dwarf_dealloc(dbg, line_src, DW_DLA_STRING);
+			}
+			else
+			{
 				procmsg("[DWARF_ERROR] Error in dwarf_linesrc!\n");
-
-			// Store the line information
-			lines.emplace_back(line_number, line_addr, is_begin_statement, line_src);
+				table->files.emplace_back("<file_name_not_found>");
+			}
+			file_it = file_indices.emplace(file_number, table->files.size() - 1).first;
 		}
+		row.file = file_it->second;
+
+		table->rows.push_back(row);
 	}
-	else
-	{
-		procmsg("[DWARF_ERROR] Error in dwarf_srclines!\n");
-	}
-	return lines;
-}
\ No newline at end of file
+	dwarf_srclines_dealloc(dbg, line_buffer, line_count);
+
+	// Sequences may appear in any order within the line number program. When
+	// sorting, end of sequence rows are placed before any row which begins a
+	// new sequence at the same address.
+	std::stable_sort(table->rows.begin(), table->rows.end(),
+	                 [](const LineTable::Row &a, const LineTable::Row &b)
+	                 {
+	                     if (a.address != b.address)
+	                         return a.address < b.address;
+	                     return a.is_end_sequence && !b.is_end_sequence;
+	                 });
+
+	return table;
+}
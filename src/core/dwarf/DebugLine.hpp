@@ -6,26 +6,35 @@
 #include <unordered_map>
 #include <stdint.h>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include "../expected.hpp"
+#include "../SourcePaths.hpp"
+#include "../Span.hpp"
 
 #include "DIE.hpp"
+#include "DebugAddressRanges.hpp"
 
 using namespace nonstd;
 
-// Structure containing information about a single source line
-struct Line
+// A compilation unit's decoded line number program. Rows are stored compactly
+// and sorted by address so that they can be binary searched. Files are
+// numbered within the table, so that it can be cached as it is.
+struct LineTable
 {
-	Line(uint64_t number, uint64_t address, bool is_begin_statement, char *source) :
-		number(number),
-		address(address),
-		is_begin_statement(is_begin_statement),
-		source(source) {}
-
-	const uint64_t number;
-	const uint64_t address;
-	const bool is_begin_statement;
-	const char *source;
+	struct Row
+	{
+		uint64_t address;
+		uint32_t line;
+		uint16_t file;
+		bool is_begin_statement;
+		bool is_end_sequence;
+	};
+
+	std::vector<Row> rows;
+	std::vector<std::string> files;
 };
 
 // Represents the information presented when performing a call to
@@ -33,18 +42,51 @@ struct Line
 class DebugLine
 {
 public:
-	DebugLine(const std::vector<DIE> &compile_units);
+	DebugLine(const Dwarf_Debug &dbg, const std::vector<DIE> &compile_units,
+	          std::shared_ptr<DebugAddressRanges> address_ranges,
+	          std::shared_ptr<SourcePathTable> source_paths);
+
+	// Decodes the line number program of a compilation unit. The DIE may be
+	// from a DIETree, in which case the compilation unit is found by offset.
+	static std::unique_ptr<LineTable> decodeLineTable(const Dwarf_Debug &dbg,
+	                                                  const DIE &compile_unit);
+
+	// Gets the primary source file of a compilation unit, which the header of
+	// its line table names first. Skeletons of split units have no name of
+	// their own, but their line tables are in the executable.
+	static expected<std::string, std::string> getPrimarySourceFile(const Dwarf_Debug &dbg,
+	                                                               const DIE &compile_unit);
+
+	// Provides a table decoded ahead of time, such as by an indexing worker
+	void setLineTable(Dwarf_Off cu_offset, std::unique_ptr<LineTable> table);
 
-	// std::optional<Line> getLine(uint64_t address);
-	std::vector<Line> getFunctionLines(uint64_t address);
-	std::vector<Line> getCULines(uint64_t address);
-	std::vector<Line> getCULines(const DIE &compile_unit);
+	// Lines are views of the tables, which are kept for as long as this is
+	expected<SourceLine, std::string> getLine(uint64_t address);
+	Span<SourceLine> getAddressRangeLines(uint64_t start_address, uint64_t end_address);
+	Span<SourceLine> getCULines(uint64_t address);
+	Span<SourceLine> getCULines(const DIE &compile_unit);
 
 private:
+	// A line table once its files have been added to the path table. The rows
+	// which end sequences are kept apart, so that the rest can be handed out
+	// as they are.
+	struct Lines
+	{
+		std::vector<SourceLine> rows;
+		std::vector<uint64_t> sequence_ends;
+	};
+
+	Dwarf_Debug dbg;
 	std::vector<DIE> compile_units;
+	std::unordered_map<Dwarf_Off, size_t> compile_units_by_offset;
+	std::shared_ptr<DebugAddressRanges> address_ranges;
+	std::shared_ptr<SourcePathTable> source_paths;
+
+	// Line tables are decoded the first time their compilation unit is queried
+	std::mutex line_tables_mtx;
+	std::unordered_map<Dwarf_Off, std::unique_ptr<Lines>> line_tables;
 
 	expected<DIE, std::string> getCompileUnit(uint64_t address);
-	std::vector<Line> generateLineInfo(const DIE &compile_unit,
-	                                   uint64_t start_address = 0,
-	                                   uint64_t end_address = 0);
-};
\ No newline at end of file
+	const Lines &getLines(const DIE &compile_unit);
+	std::unique_ptr<Lines> internLines(const LineTable &table);
+};
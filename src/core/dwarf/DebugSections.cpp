@@ -0,0 +1,323 @@
+#include "DebugSections.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <zlib.h>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+// A compressed section, and where its contents are inflated to
+struct CompressedSection
+{
+	size_t index;
+	ByteSpan stream;
+	size_t scratch_offset;
+	uint64_t size;
+};
+
+static bool startsWith(const std::string &str, const char *prefix)
+{
+	return str.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Reads the header in front of a compressed section's zlib stream, which
+// gives the size of the section once inflated. SHF_COMPRESSED sections start
+// with an ELF compression header, while .zdebug_* sections start with "ZLIB"
+// and a big-endian 64-bit size.
+static bool readCompressionHeader(const ELFFile::Section &section, bool is_64_bit,
+                                  ByteSpan &stream, uint64_t &size)
+{
+	const uint8_t *data = section.data.data;
+	size_t header_size;
+	if (section.flags & SHF_COMPRESSED)
+	{
+		uint32_t type;
+		if (is_64_bit)
+		{
+			Elf64_Chdr header;
+			header_size = sizeof(header);
+			if (section.data.size < header_size)
+				return false;
+			memcpy(&header, data, sizeof(header));
+			type = header.ch_type;
+			size = header.ch_size;
+		}
+		else
+		{
+			Elf32_Chdr header;
+			header_size = sizeof(header);
+			if (section.data.size < header_size)
+				return false;
+			memcpy(&header, data, sizeof(header));
+			type = header.ch_type;
+			size = header.ch_size;
+		}
+		if (type != ELFCOMPRESS_ZLIB)
+			return false;
+	}
+	else
+	{
+		header_size = 12;
+		if (section.data.size < header_size || memcmp(data, "ZLIB", 4) != 0)
+			return false;
+		size = 0;
+		for (size_t i = 4; i < header_size; i++)
+			size = (size << 8) | data[i];
+	}
+
+	stream = ByteSpan{data + header_size, section.data.size - header_size};
+	return true;
+}
+
+// Maps a scratch file for the inflated sections. The file is unlinked as soon
+// as it is created, so it only lasts as long as the mapping, but its pages can
+// be written back to it rather than to swap when memory is short.
+static uint8_t *mapScratchFile(size_t size)
+{
+	const char *temp_directory = getenv("TMPDIR");
+	std::string path = std::string(temp_directory != nullptr ? temp_directory : "/tmp") +
+	                   "/vdb_sections_XXXXXX";
+
+	void *address = MAP_FAILED;
+	int fd = mkstemp(&path[0]);
+	if (fd >= 0)
+	{
+		unlink(path.c_str());
+		if (ftruncate(fd, size) == 0)
+			address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+	}
+	if (address == MAP_FAILED)
+		address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return address != MAP_FAILED ? static_cast<uint8_t *>(address) : nullptr;
+}
+
+// Inflates compressed sections until there are none left. Each section is
+// inflated into a part of the scratch file of its own.
+static void inflateSections(uint8_t *scratch, const std::vector<CompressedSection> &compressed,
+                            std::atomic<size_t> &next_section, std::vector<char> &inflated)
+{
+	for (size_t i = next_section++; i < compressed.size(); i = next_section++)
+	{
+		const CompressedSection &section = compressed[i];
+		uLongf size = section.size;
+		int result = uncompress(scratch + section.scratch_offset, &size,
+		                        section.stream.data, section.stream.size);
+		inflated[i] = (result == Z_OK && size == section.size);
+	}
+}
+
+const Dwarf_Obj_Access_Methods DebugSections::access_methods = {
+	DebugSections::getSectionInfo,
+	DebugSections::getByteOrder,
+	DebugSections::getLengthSize,
+	DebugSections::getPointerSize,
+	DebugSections::getSectionCount,
+	DebugSections::loadSection,
+	DebugSections::relocateSection
+};
+
+DebugSections::DebugSections(std::shared_ptr<const ELFFile> elf_file, unsigned int thread_count) :
+	elf_file(elf_file),
+	scratch(nullptr),
+	scratch_size(0),
+	compressed_count(0)
+{
+	access_interface.object = this;
+	access_interface.methods = &access_methods;
+
+	const auto &elf_sections = elf_file->sections();
+	sections.resize(elf_sections.size());
+	for (size_t i = 0; i < elf_sections.size(); i++)
+	{
+		sections[i].name = std::string(elf_sections[i].name);
+		sections[i].data = elf_sections[i].data;
+	}
+
+	decompressSections(thread_count);
+}
+
+DebugSections::~DebugSections()
+{
+	if (scratch != nullptr)
+		munmap(scratch, scratch_size);
+}
+
+expected<ByteSpan, std::string> DebugSections::sectionData(const std::string &section_name) const
+{
+	for (const auto &section : sections)
+	{
+		if (section.name == section_name)
+			return section.data;
+	}
+	return make_unexpected("Section " + section_name + " not found in ELF file: " + elf_file->filePath());
+}
+
+size_t DebugSections::compressedSectionCount() const
+{
+	return compressed_count;
+}
+
+int DebugSections::initDwarf(Dwarf_Handler handler, Dwarf_Ptr errarg, Dwarf_Debug *dbg,
+                             Dwarf_Error *error) const
+{
+	return dwarf_object_init(&access_interface, handler, errarg, dbg, error);
+}
+
+std::shared_ptr<const ELFFile> DebugSections::elf() const
+{
+	return elf_file;
+}
+
+void DebugSections::decompressSections(unsigned int thread_count)
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	// The inflated size of every section is known from its header, so each
+	// can be given its place in the scratch file before any are inflated
+	const auto &elf_sections = elf_file->sections();
+	std::vector<CompressedSection> compressed;
+	for (size_t i = 0; i < elf_sections.size(); i++)
+	{
+		const ELFFile::Section &elf_section = elf_sections[i];
+		bool is_zdebug = startsWith(sections[i].name, ".zdebug");
+		bool is_compressed = (elf_section.flags & SHF_COMPRESSED) || is_zdebug;
+		if (!is_compressed || elf_section.data.size == 0)
+			continue;
+
+		// libdwarf only recognises the uncompressed names
+		if (is_zdebug)
+			sections[i].name = "." + sections[i].name.substr(2);
+
+		CompressedSection section;
+		section.index = i;
+		section.scratch_offset = scratch_size;
+		if (!readCompressionHeader(elf_section, elf_file->is64Bit(), section.stream, section.size))
+		{
+			procmsg("[DWARF_ERROR] Unsupported compression of section %s!\n", sections[i].name.c_str());
+			sections[i].data = ByteSpan();
+			continue;
+		}
+		compressed.push_back(section);
+		scratch_size += (section.size + 15) & ~static_cast<uint64_t>(15);
+	}
+	if (compressed.empty())
+		return;
+
+	scratch = (scratch_size > 0) ? mapScratchFile(scratch_size) : nullptr;
+	if (scratch == nullptr)
+	{
+		procmsg("[DWARF_ERROR] Failed to map %lu bytes for decompressed sections!\n", scratch_size);
+		for (const auto &section : compressed)
+			sections[section.index].data = ByteSpan();
+		scratch_size = 0;
+		return;
+	}
+
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min<size_t>(thread_count, compressed.size());
+
+	std::vector<char> inflated(compressed.size(), false);
+	std::atomic<size_t> next_section(0);
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < thread_count; i++)
+	{
+		workers.emplace_back(inflateSections, scratch, std::cref(compressed),
+		                     std::ref(next_section), std::ref(inflated));
+	}
+	inflateSections(scratch, compressed, next_section, inflated);
+	for (auto &worker : workers)
+		worker.join();
+
+	// Nothing writes to the sections once they have been inflated
+	mprotect(scratch, scratch_size, PROT_READ);
+
+	for (size_t i = 0; i < compressed.size(); i++)
+	{
+		Section &section = sections[compressed[i].index];
+		if (inflated[i])
+		{
+			section.data = ByteSpan{scratch + compressed[i].scratch_offset, compressed[i].size};
+			compressed_count++;
+		}
+		else
+		{
+			procmsg("[DWARF_ERROR] Failed to decompress section %s!\n", section.name.c_str());
+			section.data = ByteSpan();
+		}
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+	procmsg("[DWARF] Decompressed %lu sections (%lu bytes) with %u workers in %.1f ms\n",
+	        compressed_count, scratch_size, thread_count, elapsed.count());
+}
+
+int DebugSections::getSectionInfo(void *object, Dwarf_Half index, Dwarf_Obj_Access_Section *section, int *)
+{
+	const DebugSections *debug_sections = static_cast<const DebugSections *>(object);
+	if (index >= debug_sections->sections.size())
+		return DW_DLV_NO_ENTRY;
+
+	const ELFFile::Section &elf_section = debug_sections->elf_file->sections()[index];
+	const Section &debug_section = debug_sections->sections[index];
+	memset(section, 0, sizeof(*section));
+	section->addr = elf_section.address;
+	section->type = elf_section.type;
+	section->size = debug_section.data.size;
+	section->name = debug_section.name.c_str();
+	section->link = elf_section.link;
+	section->info = elf_section.info;
+	section->entrysize = elf_section.entry_size;
+	return DW_DLV_OK;
+}
+
+Dwarf_Endianness DebugSections::getByteOrder(void *object)
+{
+	const DebugSections *debug_sections = static_cast<const DebugSections *>(object);
+	return debug_sections->elf_file->isLittleEndian() ? DW_OBJECT_LSB : DW_OBJECT_MSB;
+}
+
+Dwarf_Small DebugSections::getLengthSize(void *)
+{
+	// Units using 64-bit DWARF say so in their headers
+	return 4;
+}
+
+Dwarf_Small DebugSections::getPointerSize(void *object)
+{
+	const DebugSections *debug_sections = static_cast<const DebugSections *>(object);
+	return debug_sections->elf_file->is64Bit() ? 8 : 4;
+}
+
+Dwarf_Unsigned DebugSections::getSectionCount(void *object)
+{
+	const DebugSections *debug_sections = static_cast<const DebugSections *>(object);
+	return debug_sections->sections.size();
+}
+
+int DebugSections::loadSection(void *object, Dwarf_Half index, Dwarf_Small **data, int *)
+{
+	const DebugSections *debug_sections = static_cast<const DebugSections *>(object);
+	if (index >= debug_sections->sections.size() || debug_sections->sections[index].data.size == 0)
+		return DW_DLV_NO_ENTRY;
+
+	// libdwarf only writes to sections it relocates, which these never are
+	*data = const_cast<Dwarf_Small *>(debug_sections->sections[index].data.data);
+	return DW_DLV_OK;
+}
+
+int DebugSections::relocateSection(void *, Dwarf_Half, Dwarf_Debug, int *)
+{
+	// Executables and shared objects are already relocated
+	return DW_DLV_NO_ENTRY;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+
+#include "../ELFFile.hpp"
+#include "../expected.hpp"
+
+using namespace nonstd;
+
+// The sections of an ELF file as the DWARF readers see them. Compressed debug
+// sections (SHF_COMPRESSED, or the older .zdebug_* format) are inflated once,
+// when the sections are read, into a scratch file which is mapped and shared
+// by every reader. All other sections are served from the ELF file's mapping.
+class DebugSections
+{
+public:
+	// Compressed sections are inflated in parallel by up to thread_count
+	// workers, or one per hardware thread if zero
+	DebugSections(std::shared_ptr<const ELFFile> elf_file, unsigned int thread_count = 0);
+	~DebugSections();
+
+	DebugSections(const DebugSections &other) = delete;
+	DebugSections &operator=(const DebugSections &other) = delete;
+
+	// Gets the contents of a section. Sections from .zdebug_* are found by
+	// their uncompressed names (".debug_info" rather than ".zdebug_info").
+	expected<ByteSpan, std::string> sectionData(const std::string &section_name) const;
+	size_t compressedSectionCount() const;
+
+	// Starts a libdwarf instance which reads these sections, and must be
+	// released with dwarf_object_finish(). The sections are never modified,
+	// so instances on different threads can share them.
+	int initDwarf(Dwarf_Handler handler, Dwarf_Ptr errarg, Dwarf_Debug *dbg, Dwarf_Error *error) const;
+
+	std::shared_ptr<const ELFFile> elf() const;
+
+private:
+	struct Section
+	{
+		std::string name;
+		ByteSpan data;
+	};
+
+	std::shared_ptr<const ELFFile> elf_file;
+	// Indexed the same way as the ELF file's sections
+	std::vector<Section> sections;
+	uint8_t *scratch;
+	size_t scratch_size;
+	size_t compressed_count;
+	// libdwarf keeps a pointer to this for as long as an instance is open
+	mutable Dwarf_Obj_Access_Interface access_interface;
+
+	void decompressSections(unsigned int thread_count);
+
+	static const Dwarf_Obj_Access_Methods access_methods;
+	static int getSectionInfo(void *object, Dwarf_Half index, Dwarf_Obj_Access_Section *section, int *error);
+	static Dwarf_Endianness getByteOrder(void *object);
+	static Dwarf_Small getLengthSize(void *object);
+	static Dwarf_Small getPointerSize(void *object);
+	static Dwarf_Unsigned getSectionCount(void *object);
+	static int loadSection(void *object, Dwarf_Half index, Dwarf_Small **data, int *error);
+	static int relocateSection(void *object, Dwarf_Half index, Dwarf_Debug dbg, int *error);
+};
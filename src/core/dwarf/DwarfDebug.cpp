@@ -1,6 +1,10 @@
 #include "DwarfDebug.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <thread>
 
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
@@ -10,31 +14,308 @@ static void simple_error_handler(Dwarf_Error error, Dwarf_Ptr errarg)
 	printf("libdwarf error: %llu %s0", dwarf_errno(error), dwarf_errmsg(error));
 }
 
-DwarfDebug::DwarfDebug(std::string filename)
+// Indexes compilation units until there are none left, or indexing is
+// cancelled. libdwarf isn't thread safe, so each worker reads the shared
+// sections through an instance of its own.
+static void indexCompileUnits(std::shared_ptr<const DebugSections> sections, std::shared_ptr<const DIETree> tree,
+                              const std::vector<Dwarf_Off> &cu_offsets,
+                              std::atomic<size_t> &next_cu,
+                              const std::atomic<bool> &is_cancelled,
+                              const std::function<void()> &on_indexed,
+                              std::vector<CompileUnitIndex> &results)
 {
-	// Open the file in question
-	file = fopen(filename.c_str(), "r");
-	int file_descriptor = fileno(file);
+	Dwarf_Debug dbg;
+	if (sections->initDwarf(simple_error_handler, nullptr, &dbg, nullptr) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Indexing worker failed to initialize libdwarf!\n");
+		return;
+	}
+
+	// DIEs are still read from the tree if there is one, but line tables
+	// always need a libdwarf instance
+	DwarfInfoReader reader(dbg);
+	reader.setTree(tree);
+	for (size_t i = next_cu++; i < cu_offsets.size() && !is_cancelled; i = next_cu++)
+	{
+		CompileUnitIndex &result = results[i];
+		if (result.is_indexed)
+			continue;
+		std::unique_ptr<DIE> cu = reader.getDIEByOffset(cu_offsets[i]);
+		if (cu == nullptr)
+			continue;
+
+		result.offset = cu_offsets[i];
+		result.functions = FunctionIndex::indexCompileUnit(reader, *cu);
+		result.scopes = ScopeIndex::indexCompileUnit(reader, *cu);
+		result.line_table = DebugLine::decodeLineTable(dbg, *cu);
+		result.is_indexed = true;
+		on_indexed();
+	}
+
+	// Nothing read by this instance is referenced once it has finished
+	dwarf_object_finish(dbg, nullptr);
+}
 
-	// Initialize libdwarf
+// Gets the names of the global variables defined directly within a DIE or its
+// namespaces, qualified the same way as in the scope index
+static void findGlobalNames(DwarfInfoReader &reader, const DIE &die, const std::string &name_prefix,
+                            std::vector<std::string> &names)
+{
+	reader.visitChildren(die, [&](DIE &child)
+	{
+		Dwarf_Half tag = child.getTag();
+		if (tag == DW_TAG_variable && child.getAttributeForm<DW_AT_location>() == DW_FORM_exprloc)
+		{
+			// Out-of-line definitions of static members carry their name on
+			// the declaration
+			auto [name, specification] = child.getAttributeValues<DW_AT_name, DW_AT_specification>();
+			if (specification)
+			{
+				std::unique_ptr<DIE> decl = reader.getDIEByOffset(specification.value());
+				if (decl != nullptr)
+					name = decl->getAttributeValue<DW_AT_name>();
+			}
+			if (name)
+				names.push_back(name_prefix + name.value());
+		}
+		else if (tag == DW_TAG_namespace)
+		{
+			char default_name[] = "(anonymous namespace)";
+			std::string name = child.getAttributeValue<DW_AT_name>().value_or(default_name);
+			findGlobalNames(reader, child, name_prefix + name + "::", names);
+		}
+		return SKIP_CHILDREN;
+	});
+}
+
+DwarfDebug::DwarfDebug(std::string filename, const DwarfLoadOptions &options) :
+	DwarfDebug(std::make_shared<ELFFile>(filename), options)
+{
+}
+
+DwarfDebug::DwarfDebug(std::shared_ptr<ELFFile> elf_file, const DwarfLoadOptions &options) :
+	elf_file(elf_file),
+	debug_file(DebugFileLocator().locate(elf_file)),
+	sections(std::make_shared<DebugSections>(debug_file, options.index_threads)),
+	index_progress(options.progress),
+	is_index_cancelled(false)
+{
+	// Initialize libdwarf over the file's existing mapping, and any sections
+	// which had to be decompressed
 	Dwarf_Ptr errarg;
-	dwarf_init(file_descriptor, DW_DLC_READ, simple_error_handler, &errarg, &dbg, NULL);
+	sections->initDwarf(simple_error_handler, &errarg, &dbg, NULL);
 
 	// Initialize the various DWARF debugging components
 	debug_info = std::make_shared<DwarfInfoReader>(dbg);
-	debug_line = std::make_shared<DebugLine>(debug_info->getCompileUnits());
-	debug_aranges = std::make_shared<DebugAddressRanges>(dbg);
+	debug_info->setNameTable(NameTable::read(sections));
+	if (debug_info->getNameTable() != nullptr)
+		procmsg("[DWARF] Using %s for name lookups\n", debug_info->getNameTable()->getSectionName());
+	if (options.flatten_dies)
+		debug_info->setTree(std::make_shared<DIETree>(*debug_info));
+	compile_units = debug_info->getCompileUnits();
+	debug_aranges = std::make_shared<DebugAddressRanges>(dbg, compile_units);
+	source_paths = std::make_shared<SourcePathTable>();
+	debug_line = std::make_shared<DebugLine>(dbg, compile_units, debug_aranges, source_paths);
+
+	unit_indices.resize(compile_units.size());
+	for (size_t i = 0; i < compile_units.size(); i++)
+		compile_units_by_offset.emplace(compile_units[i].getOffset(), i);
+	findSplitUnits();
+
+	// A valid cache holds the indices of every compilation unit, so makes
+	// lazy loading unnecessary
+	std::unique_ptr<IndexCache> cache = nullptr;
+	std::vector<CompileUnitIndex> units;
+	if (!options.cache_directory.empty())
+	{
+		cache = std::make_unique<IndexCache>(*elf_file, options.cache_directory);
+		units = loadCachedIndices(*cache);
+	}
+
+	// Lazily loaded compilation units are indexed by this thread's instance,
+	// as only a few are expected to be touched
+	bool is_background = options.background && !options.flatten_dies && units.empty();
+	is_lazy = (options.lazy || is_background) && !options.flatten_dies && units.empty();
+	if (is_background)
+	{
+		procmsg("[DWARF] Found %lu compilation units, which will be indexed in the background\n",
+		        compile_units.size());
+		background_indexing = std::async(std::launch::async, &DwarfDebug::indexInBackground, this,
+		                                 options.index_threads, std::move(cache)).share();
+		return;
+	}
+	if (is_lazy)
+	{
+		procmsg("[DWARF] Found %lu compilation units, which will be indexed on first use\n",
+		        compile_units.size());
+		return;
+	}
+
+	if (units.empty())
+	{
+		units = buildIndices(options.index_threads);
+		if (units.size() != compile_units.size())
+		{
+			procmsg("[DWARF_ERROR] Failed to index compilation units, which will be indexed on first use!\n");
+			is_lazy = true;
+			return;
+		}
+		if (cache != nullptr)
+			cache->store(units);
+	}
+	mergeIndices(std::move(units));
+	if (index_progress)
+		index_progress(compile_units.size(), compile_units.size());
 }
 
 DwarfDebug::~DwarfDebug()
 {
-	// Finish using libdwarf and close the file stream
-	int result = dwarf_finish(dbg, NULL);
+	// The background workers read through this instance's sections, so have
+	// to stop before anything is torn down
+	is_index_cancelled = true;
+	waitUntilIndexed();
+
+	// Split files are tied to this instance, so are finished with first
+	unit_indices.clear();
+	split_files.clear();
+
+	// Finish using libdwarf. The file stays mapped for as long as anything
+	// else shares it.
+	int result = dwarf_object_finish(dbg, NULL);
 	if (result != DW_DLV_OK)
 	{
 		procmsg("[DWARF_ERROR] Error during finishing operation!\n");
 	}
-	fclose(file);
+}
+
+std::vector<CompileUnitIndex> DwarfDebug::buildIndices(unsigned int thread_count)
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	std::vector<Dwarf_Off> cu_offsets;
+	cu_offsets.reserve(compile_units.size());
+	for (const auto &cu : compile_units)
+		cu_offsets.push_back(cu.getOffset());
+
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+	thread_count = std::min<size_t>(thread_count, std::max<size_t>(1, cu_offsets.size()));
+
+	// Progress is reported about a hundred times, rather than for every unit.
+	// The last report is left to the caller, once the indices are ready.
+	std::atomic<size_t> indexed_count(0);
+	size_t report_interval = std::max<size_t>(1, cu_offsets.size() / 100);
+	std::function<void()> on_indexed = [&]()
+	{
+		size_t count = ++indexed_count;
+		if (index_progress && count % report_interval == 0 && count < cu_offsets.size())
+			index_progress(count, cu_offsets.size());
+	};
+
+	std::vector<CompileUnitIndex> results(cu_offsets.size());
+	std::atomic<size_t> next_cu(0);
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < thread_count; i++)
+	{
+		workers.emplace_back(indexCompileUnits, sections, debug_info->getTree(),
+		                     std::cref(cu_offsets), std::ref(next_cu), std::cref(is_index_cancelled),
+		                     std::cref(on_indexed), std::ref(results));
+	}
+	for (auto &worker : workers)
+		worker.join();
+
+	// Units are only left over if no worker could start. This thread then
+	// tries an instance of its own, as the executable's instance may be in
+	// use by queries. If that fails too, the units are left to be indexed on
+	// first use.
+	bool is_complete = std::all_of(results.begin(), results.end(),
+	                               [](const CompileUnitIndex &result) { return result.is_indexed; });
+	if (!is_complete && !is_index_cancelled)
+	{
+		next_cu = 0;
+		indexCompileUnits(sections, debug_info->getTree(), cu_offsets, next_cu, is_index_cancelled,
+		                  on_indexed, results);
+		is_complete = std::all_of(results.begin(), results.end(),
+		                          [](const CompileUnitIndex &result) { return result.is_indexed; });
+	}
+	if (!is_complete || is_index_cancelled)
+		return {};
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+	procmsg("[DWARF] Indexed %lu compilation units with %u workers in %.1f ms\n",
+	        cu_offsets.size(), thread_count, elapsed.count());
+	return results;
+}
+
+void DwarfDebug::indexInBackground(unsigned int thread_count, std::unique_ptr<IndexCache> cache)
+{
+	// Only the workers' own libdwarf instances are used here, as queries are
+	// reading through the executable's instance at the same time
+	std::vector<CompileUnitIndex> units = buildIndices(thread_count);
+	if (units.size() != compile_units.size())
+		return;
+	if (cache != nullptr)
+		cache->store(units);
+
+	// The merged indices are only read once the units stop being indexed on
+	// first use, so nothing else can be reading them yet
+	mergeIndices(std::move(units));
+	is_lazy = false;
+
+	if (index_progress)
+		index_progress(compile_units.size(), compile_units.size());
+}
+
+std::vector<CompileUnitIndex> DwarfDebug::loadCachedIndices(const IndexCache &cache)
+{
+	auto start_time = std::chrono::steady_clock::now();
+
+	auto expected_units = cache.load();
+	if (!expected_units)
+	{
+		procmsg("[DWARF] %s\n", expected_units.error().c_str());
+		return {};
+	}
+
+	// The cache must describe the same compilation units, in the same order
+	std::vector<CompileUnitIndex> &units = expected_units.value();
+	bool is_matching = (units.size() == compile_units.size());
+	for (size_t i = 0; is_matching && i < units.size(); i++)
+		is_matching = (units[i].offset == compile_units[i].getOffset());
+	if (!is_matching)
+	{
+		procmsg("[DWARF] Index cache %s doesn't match the executable\n", cache.path().c_str());
+		return {};
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+	procmsg("[DWARF] Loaded %lu compilation units from index cache %s in %.1f ms\n",
+	        units.size(), cache.path().c_str(), elapsed.count());
+	return std::move(units);
+}
+
+void DwarfDebug::mergeIndices(std::vector<CompileUnitIndex> units)
+{
+	// The parts are merged in compilation unit order, so that the indices are
+	// the same however the work was scheduled
+	std::vector<FunctionIndex::Part> function_parts;
+	std::vector<ScopeIndex::Part> scope_parts;
+	function_parts.reserve(units.size());
+	scope_parts.reserve(units.size());
+	for (auto &unit : units)
+	{
+		function_parts.push_back(std::move(unit.functions));
+		scope_parts.push_back(std::move(unit.scopes));
+		if (unit.line_table != nullptr)
+			debug_line->setLineTable(unit.offset, std::move(unit.line_table));
+	}
+	function_index = std::make_shared<FunctionIndex>(std::move(function_parts));
+	scope_index = std::make_shared<ScopeIndex>(std::move(scope_parts));
+}
+
+std::shared_ptr<ELFFile> DwarfDebug::elf()
+{
+	return elf_file;
 }
 
 std::shared_ptr<DwarfInfoReader> DwarfDebug::info()
@@ -47,24 +328,295 @@ std::shared_ptr<DebugLine> DwarfDebug::line()
 	return debug_line;
 }
 
+std::shared_ptr<SourcePathTable> DwarfDebug::paths()
+{
+	return source_paths;
+}
+
 std::shared_ptr<DebugAddressRanges> DwarfDebug::aranges()
 {
 	return debug_aranges;
 }
 
+DwarfDebug::Indices DwarfDebug::indices(uint64_t address)
+{
+	// The merged indices aren't ready until loading stops being lazy
+	bool is_merged = !is_lazy;
+	Indices merged = is_merged ? Indices{function_index, scope_index, debug_info} : Indices();
+	if (is_merged && split_units.empty())
+		return merged;
+
+	auto expected_cu_offset = debug_aranges->getCompileUnitOffset(address);
+	if (!expected_cu_offset)
+		return merged;
+	auto it = compile_units_by_offset.find(expected_cu_offset.value());
+	if (it == compile_units_by_offset.end())
+		return merged;
+
+	bool is_indexed_on_first_use = !is_merged || split_units.count(it->second) != 0;
+	return (is_indexed_on_first_use ? loadCompileUnitAt(it->second) : merged);
+}
+
+std::shared_ptr<FunctionIndex> DwarfDebug::functions(uint64_t address)
+{
+	return indices(address).functions;
+}
+
+std::shared_ptr<ScopeIndex> DwarfDebug::scopes(uint64_t address)
+{
+	return indices(address).scopes;
+}
+
+std::vector<DwarfDebug::Indices> DwarfDebug::globalIndices(const std::string &name)
+{
+	bool is_merged = !is_lazy;
+	std::vector<Indices> global_indices;
+	if (is_merged)
+		global_indices.push_back(Indices{function_index, scope_index, debug_info});
+	if (is_merged && split_units.empty())
+		return global_indices;
+
+	for (size_t index : compileUnitsDefiningGlobal(name))
+	{
+		if (!is_merged || split_units.count(index) != 0)
+			global_indices.push_back(loadCompileUnitAt(index));
+	}
+	return global_indices;
+}
+
+std::vector<std::shared_ptr<DwarfInfoReader>> DwarfDebug::readers(const std::string &name)
+{
+	std::vector<std::shared_ptr<DwarfInfoReader>> name_readers = {debug_info};
+	if (split_units.empty())
+		return name_readers;
+
+	std::lock_guard<std::mutex> lock(units_mtx);
+	for (size_t index : compileUnitsDeclaring(name))
+	{
+		std::shared_ptr<DwarfInfoReader> reader = nullptr;
+		if (split_units.count(index) != 0 && loadSplitUnit(index, reader) != nullptr &&
+		    std::find(name_readers.begin(), name_readers.end(), reader) == name_readers.end())
+		{
+			name_readers.push_back(reader);
+		}
+	}
+	return name_readers;
+}
+
+SourceFile DwarfDebug::sourceFile(const DIE &compile_unit)
+{
+	SourceFile file;
+	char default_name[] = "<file_name_not_found>";
+	char default_dir[] = "<file_dir_not_found>";
+	auto [name, dir] = compile_unit.getAttributeValues<DW_AT_name, DW_AT_comp_dir>();
+	file.name = name.value_or(default_name);
+	file.dir = dir.value_or(default_dir);
+	if (name.has_value())
+		return file;
+
+	auto it = compile_units_by_offset.find(compile_unit.getOffset());
+	if (it == compile_units_by_offset.end() || split_units.count(it->second) == 0)
+		return file;
+
+	// The skeleton's line table is in the executable, so the .dwo file isn't
+	// opened until the unit's DIEs are needed
+	std::lock_guard<std::mutex> lock(units_mtx);
+	SplitUnit &split_unit = split_units.at(it->second);
+	if (split_unit.source_file == nullptr)
+	{
+		split_unit.source_file = std::make_unique<SourceFile>(file);
+		auto primary_file = DebugLine::getPrimarySourceFile(dbg, compile_unit);
+		if (primary_file)
+			split_unit.source_file->name = primary_file.value();
+		else
+			procmsg("[DWARF_ERROR] %s\n", primary_file.error().c_str());
+	}
+	return *split_unit.source_file;
+}
+
+bool DwarfDebug::isLazy() const
+{
+	return is_lazy;
+}
+
+void DwarfDebug::waitUntilIndexed()
+{
+	if (background_indexing.valid())
+		background_indexing.wait();
+}
+
+DwarfDebug::Indices DwarfDebug::loadCompileUnitAt(size_t index)
+{
+	// libdwarf isn't thread safe, so units are indexed one at a time
+	std::lock_guard<std::mutex> lock(units_mtx);
+
+	Indices &unit = unit_indices[index];
+	if (unit.functions == nullptr)
+	{
+		// The DIEs of split units are read from their .dwo file. If it can't
+		// be found, only the skeleton is indexed.
+		DIE cu = compile_units[index];
+		std::shared_ptr<DwarfInfoReader> reader = debug_info;
+		if (split_units.count(index) != 0)
+		{
+			std::unique_ptr<DIE> split_cu = loadSplitUnit(index, reader);
+			if (split_cu != nullptr)
+				cu = *split_cu;
+			else
+				reader = debug_info;
+		}
+
+		std::vector<FunctionIndex::Part> function_parts;
+		function_parts.push_back(FunctionIndex::indexCompileUnit(*reader, cu));
+		std::vector<ScopeIndex::Part> scope_parts;
+		scope_parts.push_back(ScopeIndex::indexCompileUnit(*reader, cu));
+
+		unit.functions = std::make_shared<FunctionIndex>(std::move(function_parts));
+		unit.scopes = std::make_shared<ScopeIndex>(std::move(scope_parts));
+		unit.info = reader;
+	}
+	return unit;
+}
+
+// Must be called with units_mtx held
+std::unique_ptr<DIE> DwarfDebug::loadSplitUnit(size_t index, std::shared_ptr<DwarfInfoReader> &reader)
+{
+	const SplitUnit &split_unit = split_units.at(index);
+	std::string path = DebugFileLocator().locateSplitUnit(*elf_file, split_unit.dwo_name, split_unit.comp_dir);
+	if (path.empty())
+	{
+		procmsg("[DWARF_ERROR] Failed to find split DWARF file %s!\n", split_unit.dwo_name.c_str());
+		return nullptr;
+	}
+
+	// A package holds many units, so is only opened once
+	std::shared_ptr<SplitDwarfFile> &split_file = split_files[path];
+	if (split_file == nullptr)
+	{
+		auto elf_file = ELFFile::open(path);
+		if (!elf_file)
+		{
+			procmsg("[DWARF_ERROR] %s\n", elf_file.error().c_str());
+			split_files.erase(path);
+			return nullptr;
+		}
+		split_file = std::make_shared<SplitDwarfFile>(elf_file.value(), dbg, simple_error_handler);
+	}
+
+	std::unique_ptr<DIE> split_cu = split_file->findCompileUnit(split_unit.dwo_id);
+	if (split_cu == nullptr)
+	{
+		procmsg("[DWARF_ERROR] Split unit %s not found in %s!\n", split_unit.dwo_name.c_str(), path.c_str());
+		return nullptr;
+	}
+	reader = split_file->info();
+	return split_cu;
+}
+
+std::vector<size_t> DwarfDebug::compileUnitsDeclaring(const std::string &name)
+{
+	std::vector<size_t> indices;
+	if (debug_info->getNameTable() == nullptr)
+	{
+		indices.resize(compile_units.size());
+		for (size_t i = 0; i < indices.size(); i++)
+			indices[i] = i;
+		return indices;
+	}
+
+	for (Dwarf_Off cu_offset : debug_info->findCompileUnitsByName(name))
+	{
+		auto it = compile_units_by_offset.find(cu_offset);
+		if (it != compile_units_by_offset.end())
+			indices.push_back(it->second);
+	}
+	return indices;
+}
+
+std::vector<size_t> DwarfDebug::compileUnitsDefiningGlobal(const std::string &name)
+{
+	if (debug_info->getNameTable() != nullptr)
+		return compileUnitsDeclaring(name);
+
+	// Without a name table, only the top level of each unit is read, which is
+	// much cheaper than indexing every unit on each name that isn't found
+	std::lock_guard<std::mutex> lock(units_mtx);
+	if (!has_global_names)
+	{
+		for (size_t i = 0; i < compile_units.size(); i++)
+		{
+			DIE cu = compile_units[i];
+			std::shared_ptr<DwarfInfoReader> reader = debug_info;
+			if (split_units.count(i) != 0)
+			{
+				std::unique_ptr<DIE> split_cu = loadSplitUnit(i, reader);
+				if (split_cu == nullptr)
+					continue;
+				cu = *split_cu;
+			}
+
+			std::vector<std::string> names;
+			findGlobalNames(*reader, cu, "", names);
+			for (const auto &global_name : names)
+				global_names[global_name].push_back(i);
+		}
+		has_global_names = true;
+	}
+
+	auto it = global_names.find(name);
+	return (it != global_names.end() ? it->second : std::vector<size_t>());
+}
+
+void DwarfDebug::findSplitUnits()
+{
+	// Skeletons name the .dwo file holding their DIEs, with DW_AT_dwo_name in
+	// DWARF5 or DW_AT_GNU_dwo_name in the GNU extension to DWARF4. DWARF5
+	// records the DWO ID, which packages need, in the skeleton's unit header,
+	// while the extension records it as an attribute.
+	std::unordered_map<Dwarf_Off, uint64_t> skeleton_dwo_ids;
+	bool has_read_headers = false;
+	for (size_t i = 0; i < compile_units.size(); i++)
+	{
+		auto [dwo_name, gnu_dwo_name, comp_dir, gnu_dwo_id] =
+			compile_units[i].getAttributeValues<DW_AT_dwo_name, DW_AT_GNU_dwo_name, DW_AT_comp_dir,
+			                                    DW_AT_GNU_dwo_id>();
+		if (!dwo_name && !gnu_dwo_name)
+			continue;
+
+		SplitUnit split_unit;
+		split_unit.comp_dir = comp_dir.value_or(const_cast<char *>("."));
+		if (dwo_name.has_value())
+		{
+			if (!has_read_headers)
+			{
+				skeleton_dwo_ids = debug_info->getSkeletonDWOIds();
+				has_read_headers = true;
+			}
+			auto it = skeleton_dwo_ids.find(compile_units[i].getOffset());
+			split_unit.dwo_name = dwo_name.value();
+			split_unit.dwo_id = (it != skeleton_dwo_ids.end() ? it->second : 0);
+		}
+		else
+		{
+			split_unit.dwo_name = gnu_dwo_name.value();
+			split_unit.dwo_id = gnu_dwo_id.value_or(0);
+		}
+		split_units.emplace(i, std::move(split_unit));
+	}
+
+	if (!split_units.empty())
+	{
+		procmsg("[DWARF] Found %lu split compilation units, which will be read on first use\n",
+		        split_units.size());
+	}
+}
+
 std::vector<SourceFile> sourceFiles(std::shared_ptr<DwarfDebug> debug_data)
 {
 	std::vector<SourceFile> files;
 
 	std::vector<DIE> compile_units = debug_data->info()->getCompileUnits();
 	for (auto &cu : compile_units)
-	{
-		SourceFile file;
-		char default_name[] = "<file_name_not_found>";
-		char default_dir[] = "<file_dir_not_found>";
-		file.name = cu.getAttributeValue<DW_AT_name>().value_or(default_name);
-		file.dir = cu.getAttributeValue<DW_AT_comp_dir>().value_or(default_dir);
-		files.push_back(file);
-	}
+		files.push_back(debug_data->sourceFile(cu));
 	return files;
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <libdwarf/dwarf.h>
@@ -9,34 +14,157 @@
 #include <string>
 #include <cstring>
 
+#include "../ELFFile.hpp"
+
+#include "DebugFileLocator.hpp"
+#include "DebugSections.hpp"
+#include "DIETree.hpp"
 #include "DwarfReader.hpp"
 #include "DebugLine.hpp"
 #include "DebugAddressRanges.hpp"
+#include "FunctionIndex.hpp"
+#include "IndexCache.hpp"
+#include "NameTable.hpp"
+#include "ScopeIndex.hpp"
+#include "SplitDwarfFile.hpp"
+
+struct DwarfLoadOptions
+{
+	// Decode every DIE up front into a DIETree, so that later queries don't
+	// call into libdwarf
+	bool flatten_dies = false;
+	// The number of workers which decompress sections and build the indices,
+	// or zero for one per hardware thread
+	unsigned int index_threads = 0;
+	// Only read the compilation units' headers and names up front, and index
+	// each unit the first time it is touched. Ignored when flattening.
+	bool lazy = false;
+	// Load lazily, then index every compilation unit on a background thread.
+	// Units touched before then are still indexed on first use.
+	bool background = false;
+	// Called with the number of compilation units indexed so far, and the
+	// total. It is called from the indexing workers, and a final time once
+	// the indices are ready.
+	std::function<void(size_t, size_t)> progress;
+	// The directory the indices are cached in between loads, or empty to
+	// always build them from scratch
+	std::string cache_directory;
+};
+
+struct SourceFile
+{
+	std::string name;
+	std::string dir;
+};
 
 class DwarfDebug
 {
 public:
-	DwarfDebug(std::string filename);
+	// The indices covering a compilation unit, and the reader of the DIEs
+	// their offsets refer to. Split units are read from their .dwo file, so
+	// have a reader of their own.
+	struct Indices
+	{
+		std::shared_ptr<FunctionIndex> functions = nullptr;
+		std::shared_ptr<ScopeIndex> scopes = nullptr;
+		std::shared_ptr<DwarfInfoReader> info = nullptr;
+	};
+
+	DwarfDebug(std::string filename, const DwarfLoadOptions &options = DwarfLoadOptions());
+	// Reads the debug information through an ELF file which is already
+	// mapped. If the executable has been stripped, it is read from a separate
+	// debug file instead.
+	DwarfDebug(std::shared_ptr<ELFFile> elf_file, const DwarfLoadOptions &options = DwarfLoadOptions());
 	~DwarfDebug();
 
+	std::shared_ptr<ELFFile> elf();
+
 	std::shared_ptr<DwarfInfoReader> info();
 	std::shared_ptr<DebugLine> line();
+	// The paths named by line tables, which their rows refer to by ID
+	std::shared_ptr<SourcePathTable> paths();
 	std::shared_ptr<DebugAddressRanges> aranges();
 
+	// Gets the indices covering an address, which are nullptr if no
+	// compilation unit contains it. When loading lazily, or if the unit was
+	// split into a .dwo file, these only cover the compilation unit containing
+	// the address, and are built the first time it is touched.
+	Indices indices(uint64_t address);
+	std::shared_ptr<FunctionIndex> functions(uint64_t address);
+	std::shared_ptr<ScopeIndex> scopes(uint64_t address);
+	// Gets the indices which may hold a global variable. When loading lazily,
+	// only the compilation units which define it are built. They are found
+	// through the name table, or without one through the names of every
+	// unit's globals, which are read the first time they're needed.
+	std::vector<Indices> globalIndices(const std::string &name);
+	// Gets the readers of every compilation unit which may declare a name,
+	// without indexing them
+	std::vector<std::shared_ptr<DwarfInfoReader>> readers(const std::string &name);
+
+	// Gets the source file a compilation unit was built from. The skeletons of
+	// split units don't name it, so it is read from their line table.
+	SourceFile sourceFile(const DIE &compile_unit);
+
+	bool isLazy() const;
+	// Blocks until indexing in the background has finished
+	void waitUntilIndexed();
+
 private:
-	FILE *file;
+	std::shared_ptr<ELFFile> elf_file;
+	// The executable itself, unless its DWARF was moved into another file
+	std::shared_ptr<ELFFile> debug_file;
+	std::shared_ptr<DebugSections> sections;
 
 	Dwarf_Debug dbg;
 
 	std::shared_ptr<DwarfInfoReader> debug_info = nullptr;
 	std::shared_ptr<DebugLine> debug_line = nullptr;
+	std::shared_ptr<SourcePathTable> source_paths = nullptr;
 	std::shared_ptr<DebugAddressRanges> debug_aranges = nullptr;
-};
+	std::shared_ptr<FunctionIndex> function_index = nullptr;
+	std::shared_ptr<ScopeIndex> scope_index = nullptr;
 
-struct SourceFile
-{
-	std::string name;
-	std::string dir;
+	// A compilation unit whose DIEs are in a .dwo file, named by its skeleton
+	struct SplitUnit
+	{
+		std::string dwo_name;
+		std::string comp_dir;
+		uint64_t dwo_id;
+		// Read from the skeleton's line table the first time it is needed
+		std::unique_ptr<SourceFile> source_file;
+	};
+
+	// Cleared once indexing in the background has finished, after which the
+	// merged indices are used for every compilation unit that isn't split
+	std::atomic<bool> is_lazy;
+	std::function<void(size_t, size_t)> index_progress;
+	std::atomic<bool> is_index_cancelled;
+	std::shared_future<void> background_indexing;
+	std::vector<DIE> compile_units;
+	std::unordered_map<Dwarf_Off, size_t> compile_units_by_offset;
+	std::unordered_map<size_t, SplitUnit> split_units;
+	// Guards the units indexed on first use, and the split files opened for
+	// them. libdwarf isn't thread safe, so units are indexed one at a time.
+	// Indexing in the background never touches this instance, only
+	// instances of its own opened on the shared sections.
+	std::mutex units_mtx;
+	std::vector<Indices> unit_indices;
+	std::unordered_map<std::string, std::shared_ptr<SplitDwarfFile>> split_files;
+	// The compilation units defining each global variable, by the qualified
+	// name the scope index gives it
+	bool has_global_names = false;
+	std::unordered_map<std::string, std::vector<size_t>> global_names;
+
+	Indices loadCompileUnitAt(size_t index);
+	std::unique_ptr<DIE> loadSplitUnit(size_t index, std::shared_ptr<DwarfInfoReader> &reader);
+	std::vector<size_t> compileUnitsDeclaring(const std::string &name);
+	std::vector<size_t> compileUnitsDefiningGlobal(const std::string &name);
+	void findSplitUnits();
+	// Returns no indices if indexing was cancelled, or any unit couldn't be indexed
+	std::vector<CompileUnitIndex> buildIndices(unsigned int thread_count);
+	void indexInBackground(unsigned int thread_count, std::unique_ptr<IndexCache> cache);
+	std::vector<CompileUnitIndex> loadCachedIndices(const IndexCache &cache);
+	void mergeIndices(std::vector<CompileUnitIndex> units);
 };
 
 std::vector<SourceFile> sourceFiles(std::shared_ptr<DwarfDebug> debug_data);
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "DwarfExprInterpreter.hpp"
 
-#include <cmath>
+#include <cstring>
 
 #include "../Unwinder.hpp"
 
@@ -10,8 +10,8 @@ DwarfExprInterpreter::DwarfExprInterpreter(pid_t target_pid)
 }
 
 // Gets the address of the variable from the specified DWARF expressions
-uint64_t DwarfExprInterpreter::parse(uint8_t *frame_base_expr, uint8_t op_code,
-                                     uint8_t *op_param)
+uint64_t DwarfExprInterpreter::parse(const uint8_t *frame_base_expr, uint8_t op_code,
+                                     const uint8_t *op_param)
 {
 	if (op_code == DW_OP_addr) // 0x3
 	{
@@ -64,24 +64,16 @@ int64_t DwarfExprInterpreter::decodeSLEB128(const uint8_t *p)
 	return value;
 }
 
-uint64_t DwarfExprInterpreter::decodeDataAddress(uint8_t *op_param)
+uint64_t DwarfExprInterpreter::decodeDataAddress(const uint8_t *op_param)
 {
-	// The address value is read in reverse, so multiply each byte of
-	// the address by 256^n (where n represents the amount of bytes that
-	// were read before the current byte) before adding to the total
-	// address value
+	// The operand is a whole target-sized address, which is read in one go
+	// as any of its bytes may be zero
 	uint64_t addr = 0;
-	size_t idx = 0;
-	while (op_param[idx] != 0)
-	{
-		uint64_t multiplier = std::pow(256, idx);
-		addr += (multiplier * op_param[idx]);
-		++idx;
-	}
+	std::memcpy(&addr, op_param, sizeof(addr));
 	return addr;
 }
 
-uint64_t DwarfExprInterpreter::decodeStackFrameAddress(uint8_t *op_param,
+uint64_t DwarfExprInterpreter::decodeStackFrameAddress(const uint8_t *op_param,
                                                        uint8_t frame_base_op_code)
 {
 	// Use the Canonical Frame Address (CFA) to get this value
@@ -2,8 +2,7 @@
 
 #include <cassert>
 #include <algorithm>
-
-#include <sys/ptrace.h>
+#include <cstring>
 
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
@@ -12,7 +11,7 @@ void procmsg(const char* format, ...);
 // DIEMatcher
 // =============================================================================
 
-DIEMatcher &DIEMatcher::setTags(const std::vector<std::string> &tags)
+DIEMatcher &DIEMatcher::setTags(const std::vector<Dwarf_Half> &tags)
 {
 	this->tags = tags;
 	return *this;
@@ -24,6 +23,12 @@ DIEMatcher &DIEMatcher::setAttrCodes(const std::vector<Dwarf_Half> &attr_codes)
 	return *this;
 }
 
+DIEMatcher &DIEMatcher::setPrunedTags(const std::vector<Dwarf_Half> &pruned_tags)
+{
+	this->pruned_tags = pruned_tags;
+	return *this;
+}
+
 // bool DIEMatcher::matches(DIE &die)
 // {
 // 	auto tag_it = std::find(std::begin(tags), std::end(tags), die.getTagName());
@@ -45,7 +50,7 @@ DIEMatcher &DIEMatcher::setAttrCodes(const std::vector<Dwarf_Half> &attr_codes)
 // }
 bool DIEMatcher::matches(DIE &die)
 {
-	auto tag_it = std::find(std::begin(tags), std::end(tags), die.getTagName());
+	auto tag_it = std::find(std::begin(tags), std::end(tags), die.getTag());
 	bool is_tag_match = tag_it != std::end(tags);
 
 	// bool is_code_match = true;
@@ -56,6 +61,12 @@ bool DIEMatcher::matches(DIE &die)
 	return (tags.empty() || is_tag_match);// && (attr_codes.empty() || is_code_match);
 }
 
+bool DIEMatcher::shouldVisitChildren(DIE &die)
+{
+	auto tag_it = std::find(std::begin(pruned_tags), std::end(pruned_tags), die.getTag());
+	return tag_it == std::end(pruned_tags);
+}
+
 // =============================================================================
 // DwarfInfoReader
 // =============================================================================
@@ -65,10 +76,37 @@ DwarfInfoReader::DwarfInfoReader(const Dwarf_Debug &dbg)
 	this->dbg = dbg;
 }
 
+void DwarfInfoReader::setTree(std::shared_ptr<const DIETree> tree)
+{
+	this->tree = tree;
+}
+
+std::shared_ptr<const DIETree> DwarfInfoReader::getTree() const
+{
+	return tree;
+}
+
+void DwarfInfoReader::setNameTable(std::shared_ptr<const NameTable> names)
+{
+	this->names = names;
+}
+
+std::shared_ptr<const NameTable> DwarfInfoReader::getNameTable() const
+{
+	return names;
+}
+
 std::vector<DIE> DwarfInfoReader::getCompileUnits()
 {
 	std::vector<DIE> compile_units;
 
+	if (tree != nullptr)
+	{
+		for (uint32_t cu : tree->getCompileUnits())
+			compile_units.emplace_back(*tree, cu);
+		return compile_units;
+	}
+
 	// Iterate over all compilation unit headers until the end is reached
 	Dwarf_Unsigned cu_header_length, abbrev_offset, next_cu_header;
 	Dwarf_Half version_stamp, address_size;
@@ -96,8 +134,49 @@ std::vector<DIE> DwarfInfoReader::getCompileUnits()
 	return compile_units;
 }
 
+std::unordered_map<Dwarf_Off, uint64_t> DwarfInfoReader::getSkeletonDWOIds()
+{
+	std::unordered_map<Dwarf_Off, uint64_t> dwo_ids;
+
+	// The headers are always read through libdwarf, as the tree doesn't keep
+	// them. Every header is read, so that the next iteration over the
+	// compilation units starts from the first.
+	Dwarf_Unsigned cu_header_length, type_offset, next_cu_header;
+	Dwarf_Half version_stamp, address_size, length_size, extension_size, unit_type;
+	Dwarf_Off abbrev_offset;
+	Dwarf_Sig8 signature;
+	Dwarf_Error err;
+	while (dwarf_next_cu_header_d(dbg, true, &cu_header_length, &version_stamp,
+	                              &abbrev_offset, &address_size, &length_size,
+	                              &extension_size, &signature, &type_offset,
+	                              &next_cu_header, &unit_type, &err) == DW_DLV_OK)
+	{
+		Dwarf_Die no_die = 0, cu_die;
+		if (unit_type != DW_UT_skeleton || dwarf_siblingof(dbg, no_die, &cu_die, &err) != DW_DLV_OK)
+			continue;
+
+		// The ID is kept in the byte order of the target, like the value of
+		// DW_AT_GNU_dwo_id
+		Dwarf_Off cu_offset;
+		if (dwarf_dieoffset(cu_die, &cu_offset, &err) == DW_DLV_OK)
+		{
+			uint64_t dwo_id;
+			memcpy(&dwo_id, signature.signature, sizeof(dwo_id));
+			dwo_ids.emplace(cu_offset, dwo_id);
+		}
+		dwarf_dealloc(dbg, cu_die, DW_DLA_DIE);
+	}
+	return dwo_ids;
+}
+
 std::unique_ptr<DIE> DwarfInfoReader::getDIEByOffset(Dwarf_Off offset)
 {
+	if (tree != nullptr)
+	{
+		uint32_t index = tree->findByOffset(offset);
+		return (index != DIETree::NO_DIE ? std::make_unique<DIE>(*tree, index) : nullptr);
+	}
+
 	Dwarf_Die found_die;
 	Dwarf_Error err;
 	int result = dwarf_offdie(dbg, offset, &found_die, &err);
@@ -111,136 +190,212 @@ std::unique_ptr<DIE> DwarfInfoReader::getDIEByOffset(Dwarf_Off offset)
 	}
 }
 
-std::vector<DIE> DwarfInfoReader::getDIEs(DIEMatcher &matcher)
+void DwarfInfoReader::visitDIEs(const DIEVisitor &visitor)
 {
-	std::vector<DIE> results;
-
-	std::vector<DIE> compile_units = getCompileUnits();
-	for (auto &cu : compile_units)
+	if (tree != nullptr)
 	{
-		std::vector<DIE> all_children = getChildrenRecursive(cu);
-		for (auto &child : all_children)
+		for (uint32_t index : tree->getCompileUnits())
 		{
-			if (matcher.matches(child))
-				results.push_back(child);
+			DIE cu(*tree, index);
+			DIEVisitResult result = visitor(cu);
+			if (result == STOP_VISITING ||
+			    (result == VISIT_CHILDREN && !visitChildren(cu, visitor)))
+			{
+				return;
+			}
 		}
+		return;
+	}
+
+	Dwarf_Unsigned cu_header_length, abbrev_offset, next_cu_header;
+	Dwarf_Half version_stamp, address_size;
+	Dwarf_Error err;
+	bool stopped = false;
+	while (dwarf_next_cu_header(dbg, &cu_header_length, &version_stamp,
+	                            &abbrev_offset, &address_size,
+	                            &next_cu_header, &err) == DW_DLV_OK)
+	{
+		// The remaining headers must still be read, otherwise the next
+		// iteration over the compilation units would resume part way through
+		Dwarf_Die no_die = 0, cu_die;
+		if (stopped || dwarf_siblingof(dbg, no_die, &cu_die, &err) != DW_DLV_OK)
+			continue;
+
+		DIE cu(dbg, cu_die);
+		DIEVisitResult result = visitor(cu);
+		if (result == STOP_VISITING)
+			stopped = true;
+		else if (result == VISIT_CHILDREN)
+			stopped = !visitChildren(cu, visitor);
+		dwarf_dealloc(dbg, cu_die, DW_DLA_DIE);
 	}
-	return results;
 }
 
-std::vector<DIE> DwarfInfoReader::getChildrenRecursive(DIE &die)
+bool DwarfInfoReader::visitChildren(const DIE &die, const DIEVisitor &visitor)
 {
-	std::vector<DIE> all_children;
+	if (die.getTree() != nullptr)
+	{
+		const DIETree &die_tree = *die.getTree();
+		for (uint32_t index = die_tree[die.getTreeIndex()].first_child; index != DIETree::NO_DIE;
+		     index = die_tree[index].next_sibling)
+		{
+			DIE child(die_tree, index);
+			DIEVisitResult result = visitor(child);
+			if (result == STOP_VISITING ||
+			    (result == VISIT_CHILDREN && !visitChildren(child, visitor)))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 
-	std::vector<DIE> children = die.getChildren();
-	all_children.insert(all_children.end(), children.begin(), children.end());
-	for (auto &child : children)
+	Dwarf_Die child_die;
+	Dwarf_Error err;
+	int result = dwarf_child(die.get(), &child_die, &err);
+	while (result == DW_DLV_OK)
 	{
-		std::vector<DIE> sub_children = getChildrenRecursive(child);
-		all_children.insert(all_children.end(), sub_children.begin(), sub_children.end());
+		DIE child(dbg, child_die);
+		DIEVisitResult visit_result = visitor(child);
+		bool stopped = (visit_result == STOP_VISITING) ||
+		               (visit_result == VISIT_CHILDREN && !visitChildren(child, visitor));
+
+		// Only a single DIE is held per level of the tree, and each is released
+		// as soon as its next sibling has been found
+		Dwarf_Die sibling_die;
+		if (!stopped)
+			result = dwarf_siblingof(dbg, child_die, &sibling_die, &err);
+		dwarf_dealloc(dbg, child_die, DW_DLA_DIE);
+		if (stopped)
+			return false;
+		child_die = sibling_die;
 	}
-	return all_children;
+	return true;
 }
 
-expected<DwarfInfoReader::VariableLocExpr, std::string> DwarfInfoReader::getVarLocExpr(const std::string &var_name,
-                                                                                       pid_t pid)
+std::vector<DIE> DwarfInfoReader::getDIEs(DIEMatcher &matcher)
 {
-	DwarfInfoReader::VariableLocExpr loc_expr;
-
-	DIEMatcher matcher;
-	matcher.setTags({"DW_TAG_subprogram"});
-
-	std::vector<DIE> subprograms = getDIEs(matcher);
-	for (auto &sub : subprograms)
+	std::vector<DIE> results;
+	visitDIEs([&](DIE &die)
 	{
-		// Ensure that the variable is within the address range of the function
-		// the IP is currently within
-		auto expected_low_pc = sub.getAttributeValue<DW_AT_low_pc>();
-		auto expected_high_pc = sub.getAttributeValue<DW_AT_high_pc>();
-		if (!expected_low_pc || !expected_high_pc)
-			continue;
-
-		user_regs_struct regs;
-		ptrace(PTRACE_GETREGS, pid, 0, &regs);
-		uint64_t low_pc = expected_low_pc.value();
-		uint64_t high_pc = expected_high_pc.value();
-		if (regs.rip < low_pc || regs.rip >= (low_pc + high_pc))
-			continue;
-
-		// Determine if this subprogram DIE has a frame base attribute
-		auto expected_frame_base = sub.getAttributeValue<DW_AT_frame_base>();
-		if (!expected_frame_base)
-			continue;
-
-		// Cast the frame base exprloc and store
-		loc_expr.frame_base = ((uint8_t *)expected_frame_base.value().ptr)[0];
+		// The visited DIE is released after this returns, so matches are
+		// looked up again to give the caller a handle of its own
+		if (matcher.matches(die))
+		{
+			std::unique_ptr<DIE> match = getDIEByOffset(die.getOffset());
+			if (match != nullptr)
+				results.push_back(*match);
+		}
+		return matcher.shouldVisitChildren(die) ? VISIT_CHILDREN : SKIP_CHILDREN;
+	});
+	return results;
+}
 
-		// Check all of this subprogram's children to check for a local variable
-		// with the same name
-		std::vector<DIE> children = sub.getChildren();
-		for (auto &child : children)
+std::vector<Dwarf_Off> DwarfInfoReader::findDIEsByName(const std::string &name)
+{
+	std::vector<Dwarf_Off> offsets;
+	if (names != nullptr)
+	{
+		for (Dwarf_Off cu_offset : findCompileUnitsByName(name))
 		{
-			// Only look at variables and formal parameters
-			if (child.getTagName() != "DW_TAG_variable" &&
-			    child.getTagName() != "DW_TAG_formal_parameter")
-			    continue;
-
-			// Ensure that the name of this variable matches before getting the
-			// location expression
-			std::string name = child.getAttributeValue<DW_AT_name>().value();
-			if (name != var_name)
-				continue;
-
-			// Ensure the variable has a location expression attribute
-			auto expected_loc = child.getAttributeValue<DW_AT_location>();
-			if (!expected_loc)
-				continue;
-
-			// Cast the location op and param and store
-			loc_expr.location_op = ((uint8_t *)expected_loc.value().ptr)[0];
-			loc_expr.location_param = &((uint8_t *)expected_loc.value().ptr)[1];
-
-			// Determine the DIE that represents the type using type offset attribute
-			Dwarf_Off type_offset = child.getAttributeValue<DW_AT_type>().value();
-			loc_expr.type = getDIEByOffset(type_offset);
-
-			return loc_expr;
+			std::unique_ptr<DIE> cu = getDIEByOffset(cu_offset);
+			if (cu != nullptr)
+				findNamedDIEs(*cu, name, offsets);
 		}
+		return offsets;
 	}
 
-	// Then look for the variable globally if it isn't found locally
-	loc_expr.frame_base = 0;
-	std::vector<DIE> compile_units = getCompileUnits();
-	for (auto &cu : compile_units)
+	visitDIEs([&](DIE &cu)
 	{
-		std::vector<DIE> cu_children = cu.getChildren();
-		for (auto &child : cu_children)
-		{
-			if (child.getTagName() != "DW_TAG_variable")
-				continue;
+		findNamedDIEs(cu, name, offsets);
+		return SKIP_CHILDREN;
+	});
+	return offsets;
+}
 
-			// Ensure that the name of this variable matches before getting the
-			// location expression
-			std::string name = child.getAttributeValue<DW_AT_name>().value();
-			if (name != var_name)
-				continue;
+std::vector<Dwarf_Off> DwarfInfoReader::findCompileUnitsByName(const std::string &name)
+{
+	std::vector<Dwarf_Off> cu_offsets;
+	if (names == nullptr)
+		return cu_offsets;
 
-			// Ensure the variable has a location expression attribute
-			auto expected_loc = child.getAttributeValue<DW_AT_location>();
-			if (!expected_loc)
-				continue;
+	// The tables list the offsets of the compilation unit headers, which
+	// precede the DIEs
+	for (Dwarf_Off header_offset : names->findCompileUnits(name))
+	{
+		Dwarf_Off cu_offset;
+		Dwarf_Error err;
+		if (dwarf_get_cu_die_offset_given_cu_header_offset(dbg, header_offset, &cu_offset, &err) == DW_DLV_OK)
+			cu_offsets.push_back(cu_offset);
+	}
+	return cu_offsets;
+}
 
-			// Cast the location op and param and store
-			loc_expr.location_op = ((uint8_t *)expected_loc.value().ptr)[0];
-			loc_expr.location_param = &((uint8_t *)expected_loc.value().ptr)[1];
+void DwarfInfoReader::findNamedDIEs(const DIE &compile_unit, const std::string &name,
+                                    std::vector<Dwarf_Off> &offsets)
+{
+	size_t first_match = offsets.size();
+	findNamedChildren(compile_unit, "", name, offsets);
+	if (offsets.size() == first_match)
+		return;
 
-			// Determine the DIE that represents the type using type offset attribute
-			Dwarf_Off type_offset = child.getAttributeValue<DW_AT_type>().value();
-			loc_expr.type = getDIEByOffset(type_offset);
+	std::unordered_set<Dwarf_Off> declarations(offsets.begin() + first_match, offsets.end());
+	findDefinitions(compile_unit, declarations, offsets);
+}
 
-			return std::move(loc_expr);
+void DwarfInfoReader::findNamedChildren(const DIE &die, const std::string &prefix,
+                                        const std::string &name, std::vector<Dwarf_Off> &offsets)
+{
+	visitChildren(die, [&](DIE &child)
+	{
+		Dwarf_Half tag = child.getTag();
+		auto child_name = child.getAttributeValue<DW_AT_name>();
+		if (!child_name && tag != DW_TAG_namespace)
+			return SKIP_CHILDREN;
+
+		// Anonymous namespaces are named the same way as in the ScopeIndex
+		char default_name[] = "(anonymous namespace)";
+		std::string qualified_name = prefix + child_name.value_or(default_name);
+		if (qualified_name == name)
+		{
+			offsets.push_back(child.getOffset());
+			return SKIP_CHILDREN;
 		}
-	}
 
-	return make_unexpected("Could not determine location expression: " + var_name);
-}
\ No newline at end of file
+		// Only the scopes which prefix the name are searched
+		bool is_scope = (tag == DW_TAG_namespace || tag == DW_TAG_class_type ||
+		                 tag == DW_TAG_structure_type || tag == DW_TAG_union_type);
+		std::string scope_prefix = qualified_name + "::";
+		if (is_scope && name.compare(0, scope_prefix.size(), scope_prefix) == 0)
+			findNamedChildren(child, scope_prefix, name, offsets);
+		return SKIP_CHILDREN;
+	});
+}
+
+void DwarfInfoReader::findDefinitions(const DIE &die, std::unordered_set<Dwarf_Off> &declarations,
+                                      std::vector<Dwarf_Off> &offsets)
+{
+	// Out-of-line definitions, such as those of member functions, have no
+	// name of their own, but refer to their declaration. The concrete
+	// instances of inlined functions refer to the abstract instance in turn,
+	// which comes before them.
+	visitChildren(die, [&](DIE &child)
+	{
+		if (child.getTag() == DW_TAG_namespace)
+		{
+			findDefinitions(child, declarations, offsets);
+			return SKIP_CHILDREN;
+		}
+
+		auto [specification, abstract_origin] =
+			child.getAttributeValues<DW_AT_specification, DW_AT_abstract_origin>();
+		bool is_definition = (specification && declarations.count(specification.value()) != 0) ||
+		                     (abstract_origin && declarations.count(abstract_origin.value()) != 0);
+		if (is_definition)
+		{
+			declarations.insert(child.getOffset());
+			offsets.push_back(child.getOffset());
+		}
+		return SKIP_CHILDREN;
+	});
+}
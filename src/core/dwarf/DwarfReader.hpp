@@ -1,10 +1,11 @@
 #pragma once
 
-#include <tuple>
 #include <vector>
 #include <string>
 #include <memory>
-#include <sys/user.h>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <libdwarf/dwarf.h>
 #include <libdwarf/libdwarf.h>
@@ -13,6 +14,19 @@
 using namespace nonstd;
 
 #include "DIE.hpp"
+#include "NameTable.hpp"
+
+// Returned by a DIE visitor to control how the rest of the tree is walked
+enum DIEVisitResult
+{
+	VISIT_CHILDREN,
+	SKIP_CHILDREN,
+	STOP_VISITING
+};
+
+// The DIE passed to a visitor is released once the visitor returns, so it must
+// not be retained. Use its offset to look it up again if it is needed later.
+using DIEVisitor = std::function<DIEVisitResult(DIE &die)>;
 
 // This contains the compilation units, and allows access to each of them.
 // A compilation unit has a specific address range, and I could perhaps narrow
@@ -23,22 +37,48 @@ class DwarfInfoReader
 public:
 	DwarfInfoReader(const Dwarf_Debug &dbg);
 
+	// Once a tree is set, DIEs are read from it rather than through libdwarf
+	void setTree(std::shared_ptr<const DIETree> tree);
+	std::shared_ptr<const DIETree> getTree() const;
+
+	// Once a name table is set, name lookups only read the compilation units
+	// which it lists
+	void setNameTable(std::shared_ptr<const NameTable> names);
+	std::shared_ptr<const NameTable> getNameTable() const;
+
 	std::vector<DIE> getCompileUnits();
+	// Gets the DWO IDs which DWARF5 skeleton units carry in their headers,
+	// keyed by the offset of each skeleton's compilation unit DIE
+	std::unordered_map<Dwarf_Off, uint64_t> getSkeletonDWOIds();
 
 	std::unique_ptr<DIE> getDIEByOffset(Dwarf_Off offset);
 
+	// Walks the DIEs of every compilation unit depth first, starting with the
+	// compilation unit DIE itself. Must not be nested with getCompileUnits().
+	void visitDIEs(const DIEVisitor &visitor);
+	// Walks the descendants of a DIE depth first. Returns false if the visitor
+	// stopped the walk.
+	bool visitChildren(const DIE &die, const DIEVisitor &visitor);
+
 	std::vector<DIE> getDIEs(DIEMatcher &matcher);
-	std::vector<DIE> getChildrenRecursive(DIE &die);
 
-	struct VariableLocExpr
-	{
-		uint8_t frame_base;
-		uint8_t location_op;
-		uint8_t *location_param;
-		std::unique_ptr<DIE> type;
-	};
-	expected<VariableLocExpr, std::string> getVarLocExpr(const std::string& var_name, pid_t pid);
+	// Finds the DIEs of the functions, variables and types declared with a
+	// name, which may be qualified ("ns::name"), along with the definitions
+	// which refer back to them. Every compilation unit is searched if there is
+	// no name table.
+	std::vector<Dwarf_Off> findDIEsByName(const std::string &name);
+	// Gets the DIE offsets of the compilation units which the name table says
+	// may declare a name. Empty if there is no name table.
+	std::vector<Dwarf_Off> findCompileUnitsByName(const std::string &name);
 
 private:
 	Dwarf_Debug dbg;
+	std::shared_ptr<const DIETree> tree = nullptr;
+	std::shared_ptr<const NameTable> names = nullptr;
+
+	void findNamedDIEs(const DIE &compile_unit, const std::string &name, std::vector<Dwarf_Off> &offsets);
+	void findNamedChildren(const DIE &die, const std::string &prefix, const std::string &name,
+	                       std::vector<Dwarf_Off> &offsets);
+	void findDefinitions(const DIE &die, std::unordered_set<Dwarf_Off> &declarations,
+	                     std::vector<Dwarf_Off> &offsets);
 };
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "FunctionIndex.hpp"
+
+#include <algorithm>
+#include <limits>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+FunctionIndex::FunctionIndex(std::vector<Part> parts)
+{
+	std::vector<FunctionRanges::Interval> intervals;
+
+	// Functions and compilation units are numbered from zero within each part
+	for (auto &part : parts)
+	{
+		uint32_t compile_unit = compile_units.size();
+		uint32_t first_function = functions.size();
+		compile_units.push_back(std::move(part.compile_unit));
+		for (auto &function : part.functions)
+		{
+			function.compile_unit = compile_unit;
+			functions.push_back(std::move(function));
+		}
+		for (const auto &interval : part.intervals)
+			intervals.push_back({interval.low, interval.high, interval.value + first_function});
+	}
+
+	ranges = FunctionRanges(std::move(intervals));
+
+	procmsg("[DWARF] Indexed %lu functions (%lu ranges) in %lu compilation units\n",
+	        functions.size(), ranges.size(), compile_units.size());
+}
+
+FunctionIndex::Part FunctionIndex::indexCompileUnit(DwarfInfoReader &reader, DIE &cu)
+{
+	Part part;
+
+	char default_name[] = "<file_name_not_found>";
+	char default_dir[] = "<file_dir_not_found>";
+
+	auto [name, comp_dir] = cu.getAttributeValues<DW_AT_name, DW_AT_comp_dir>();
+	part.compile_unit.name = name.value_or(default_name);
+	part.compile_unit.comp_dir = comp_dir.value_or(default_dir);
+	part.compile_unit.die_offset = cu.getOffset();
+
+	reader.visitChildren(cu, [&](DIE &die)
+	{
+		switch (die.getTag())
+		{
+		case DW_TAG_subprogram:
+			indexSubprogram(reader, die, part);
+			return VISIT_CHILDREN;
+		case DW_TAG_namespace:
+		case DW_TAG_lexical_block:
+			return VISIT_CHILDREN;
+		default:
+			// Types and variables never contain the definitions of functions.
+			// Member functions are only declared within their class, and
+			// defined again at namespace scope.
+			return SKIP_CHILDREN;
+		}
+	});
+	return part;
+}
+
+const FunctionEntry *FunctionIndex::find(uint64_t address) const
+{
+	const uint32_t *function = ranges.find(address);
+	return (function != nullptr ? &functions[*function] : nullptr);
+}
+
+const CompileUnitEntry &FunctionIndex::getCompileUnit(uint32_t index) const
+{
+	return compile_units.at(index);
+}
+
+size_t FunctionIndex::size() const
+{
+	return functions.size();
+}
+
+void FunctionIndex::indexSubprogram(DwarfInfoReader &reader, DIE &subprogram, Part &part)
+{
+	// Subprogram DIEs may not have address ranges. This occurs when they are
+	// declarations, or abstract instances of inlined functions.
+	std::vector<PCRange> pc_ranges = subprogram.getPCRanges();
+	if (pc_ranges.empty())
+		return;
+
+	FunctionEntry entry;
+	entry.start_address = std::numeric_limits<uint64_t>::max();
+	entry.end_address = 0;
+	entry.die_offset = subprogram.getOffset();
+	entry.compile_unit = 0;
+
+	// Out-of-line definitions (such as member functions) and concrete inlined
+	// instances carry their name and declaration line on another DIE
+	auto [name, decl_line, specification, abstract_origin] =
+		subprogram.getAttributeValues<DW_AT_name, DW_AT_decl_line,
+		                              DW_AT_specification, DW_AT_abstract_origin>();
+
+	std::unique_ptr<DIE> origin = nullptr;
+	if (!name && specification)
+		origin = reader.getDIEByOffset(specification.value());
+	else if (!name && abstract_origin)
+		origin = reader.getDIEByOffset(abstract_origin.value());
+	if (origin != nullptr)
+		std::tie(name, decl_line) = origin->getAttributeValues<DW_AT_name, DW_AT_decl_line>();
+
+	char default_name[] = "<function_name_not_found>";
+	entry.name = name.value_or(default_name);
+	entry.decl_line = decl_line.value_or(0);
+
+	uint32_t function = part.functions.size();
+	for (const auto &pc_range : pc_ranges)
+	{
+		// Functions discarded by the linker are left with a low PC of zero
+		if (pc_range.low_pc == 0 || pc_range.low_pc >= pc_range.high_pc)
+			continue;
+
+		entry.start_address = std::min(entry.start_address, pc_range.low_pc);
+		entry.end_address = std::max(entry.end_address, pc_range.high_pc);
+		part.intervals.push_back({pc_range.low_pc, pc_range.high_pc, function});
+	}
+
+	if (entry.start_address < entry.end_address)
+		part.functions.push_back(entry);
+}
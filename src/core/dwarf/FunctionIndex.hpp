@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+#include <libdwarf/dwarf.h>
+
+#include "DwarfReader.hpp"
+#include "IntervalMap.hpp"
+
+struct FunctionEntry
+{
+	std::string name;
+	uint64_t start_address;
+	uint64_t end_address;
+	uint64_t decl_line;
+	Dwarf_Off die_offset;
+	uint32_t compile_unit;
+};
+
+struct CompileUnitEntry
+{
+	std::string name;
+	std::string comp_dir;
+	Dwarf_Off die_offset;
+};
+
+// Immutable lookup table for mapping addresses to the functions containing
+// them. Every address range of every subprogram DIE is read once on
+// construction, and lookups are then performed with a binary search.
+class FunctionIndex
+{
+public:
+	using FunctionRanges = IntervalMap<uint32_t>;
+
+	// The functions of a single compilation unit. Parts can be built
+	// independently of one another, and are then merged into an index.
+	struct Part
+	{
+		CompileUnitEntry compile_unit;
+		std::vector<FunctionEntry> functions;
+		std::vector<FunctionRanges::Interval> intervals;
+	};
+
+	FunctionIndex(std::vector<Part> parts);
+
+	static Part indexCompileUnit(DwarfInfoReader &reader, DIE &cu);
+
+	const FunctionEntry *find(uint64_t address) const;
+	const CompileUnitEntry &getCompileUnit(uint32_t index) const;
+
+	size_t size() const;
+
+private:
+	std::vector<FunctionEntry> functions;
+	std::vector<CompileUnitEntry> compile_units;
+	FunctionRanges ranges;
+
+	static void indexSubprogram(DwarfInfoReader &reader, DIE &subprogram, Part &part);
+};
\ No newline at end of file
@@ -0,0 +1,492 @@
+#include "IndexCache.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../ELFFile.hpp"
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+static const std::array<char, 8> CACHE_MAGIC = {{'V', 'D', 'B', 'I', 'N', 'D', 'E', 'X'}};
+
+// Appends values to a buffer in the layout of a cache file. Plain values and
+// arrays of them are copied as they are in memory. Structures with padding
+// would copy whatever the padding happens to hold, so have to be written a
+// field at a time for identical indices to give identical files.
+class CacheWriter
+{
+public:
+	template <typename T>
+	void put(const T &value)
+	{
+		static_assert(std::has_unique_object_representations<T>::value, "Only values without padding can be copied");
+		const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T>
+	void putArray(const std::vector<T> &values)
+	{
+		static_assert(std::has_unique_object_representations<T>::value, "Only values without padding can be copied");
+		put<uint64_t>(values.size());
+		const uint8_t *bytes = reinterpret_cast<const uint8_t *>(values.data());
+		buffer.insert(buffer.end(), bytes, bytes + values.size() * sizeof(T));
+	}
+
+	void putString(const std::string &str)
+	{
+		put<uint64_t>(str.size());
+		buffer.insert(buffer.end(), str.begin(), str.end());
+	}
+
+	const std::vector<uint8_t> &data() const
+	{
+		return buffer;
+	}
+
+private:
+	std::vector<uint8_t> buffer;
+};
+
+// Reads values back out of a mapped cache file. Reading past the end of the
+// file marks the reader as failed, so that a truncated file is treated like
+// any other stale cache.
+class CacheReader
+{
+public:
+	CacheReader(const uint8_t *data, size_t size) :
+		data(data),
+		size(size),
+		position(0),
+		failed(false)
+	{
+
+	}
+
+	template <typename T>
+	T get()
+	{
+		T value{};
+		const uint8_t *bytes = take(sizeof(T));
+		if (bytes != nullptr)
+			memcpy(&value, bytes, sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	std::vector<T> getArray()
+	{
+		uint64_t count = get<uint64_t>();
+		if (count > remaining() / sizeof(T))
+		{
+			failed = true;
+			return {};
+		}
+
+		std::vector<T> values(count);
+		const uint8_t *bytes = take(count * sizeof(T));
+		if (bytes != nullptr && count > 0)
+			memcpy(values.data(), bytes, count * sizeof(T));
+		return values;
+	}
+
+	std::string getString()
+	{
+		uint64_t length = get<uint64_t>();
+		const char *chars = reinterpret_cast<const char *>(take(length));
+		return (chars != nullptr ? std::string(chars, length) : std::string());
+	}
+
+	// Reads the number of elements which follow. Every element takes at least
+	// a byte, so a count larger than the rest of the file must be corrupt.
+	uint64_t getCount()
+	{
+		uint64_t count = get<uint64_t>();
+		if (count > remaining())
+		{
+			failed = true;
+			return 0;
+		}
+		return count;
+	}
+
+	bool hasFailed() const
+	{
+		return failed;
+	}
+
+	bool isAtEnd() const
+	{
+		return position == size;
+	}
+
+private:
+	const uint8_t *data;
+	size_t size;
+	size_t position;
+	bool failed;
+
+	size_t remaining() const
+	{
+		return size - position;
+	}
+
+	const uint8_t *take(size_t length)
+	{
+		if (failed || length > remaining())
+		{
+			failed = true;
+			return nullptr;
+		}
+		const uint8_t *bytes = data + position;
+		position += length;
+		return bytes;
+	}
+};
+
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+	// 64-bit FNV-1a
+	const uint8_t *bytes = static_cast<const uint8_t *>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+static bool makeDirectories(const std::string &path)
+{
+	for (size_t i = 1; i <= path.size(); i++)
+	{
+		if (i < path.size() && path[i] != '/')
+			continue;
+		std::string prefix = path.substr(0, i);
+		if (mkdir(prefix.c_str(), 0755) < 0 && errno != EEXIST)
+			return false;
+	}
+	return true;
+}
+
+// Intervals pad their 32-bit values out to the alignment of their bounds
+static void writeIntervals(CacheWriter &writer, const std::vector<IntervalMap<uint32_t>::Interval> &intervals)
+{
+	writer.put<uint64_t>(intervals.size());
+	for (const auto &interval : intervals)
+	{
+		writer.put(interval.low);
+		writer.put(interval.high);
+		writer.put(interval.value);
+	}
+}
+
+static std::vector<IntervalMap<uint32_t>::Interval> readIntervals(CacheReader &reader)
+{
+	std::vector<IntervalMap<uint32_t>::Interval> intervals(reader.getCount());
+	for (auto &interval : intervals)
+	{
+		interval.low = reader.get<uint64_t>();
+		interval.high = reader.get<uint64_t>();
+		interval.value = reader.get<uint32_t>();
+	}
+	return intervals;
+}
+
+static void writeUnit(CacheWriter &writer, const CompileUnitIndex &unit)
+{
+	writer.put(unit.offset);
+
+	const FunctionIndex::Part &functions = unit.functions;
+	writer.putString(functions.compile_unit.name);
+	writer.putString(functions.compile_unit.comp_dir);
+	writer.put(functions.compile_unit.die_offset);
+	writer.put<uint64_t>(functions.functions.size());
+	for (const auto &function : functions.functions)
+	{
+		writer.putString(function.name);
+		writer.put(function.start_address);
+		writer.put(function.end_address);
+		writer.put(function.decl_line);
+		writer.put(function.die_offset);
+	}
+	writeIntervals(writer, functions.intervals);
+
+	const ScopeIndex::Part &scopes = unit.scopes;
+	writer.put<uint64_t>(scopes.scopes.size());
+	for (const auto &scope : scopes.scopes)
+	{
+		writer.put(scope.parent);
+		writer.put(scope.subprogram);
+		writer.putArray(scope.ranges);
+		writer.putArray(scope.children);
+		writer.put<uint64_t>(scope.variables.size());
+		for (const auto &variable : scope.variables)
+		{
+			writer.putString(variable.first);
+			writer.put(variable.second);
+		}
+		writer.put(scope.frame_base);
+	}
+	writer.putArray(scopes.variables);
+	writer.put<uint64_t>(scopes.global_variables.size());
+	for (const auto &global : scopes.global_variables)
+	{
+		writer.putString(global.first);
+		writer.put(global.second);
+	}
+	writeIntervals(writer, scopes.subprogram_intervals);
+	writer.putArray(scopes.expressions);
+
+	// Units may be stored without a line table, which is then decoded on first use
+	writer.put<uint8_t>(unit.line_table != nullptr);
+	if (unit.line_table != nullptr)
+	{
+		writer.putArray(unit.line_table->rows);
+		writer.put<uint64_t>(unit.line_table->files.size());
+		for (const auto &file : unit.line_table->files)
+			writer.putString(file);
+	}
+}
+
+static CompileUnitIndex readUnit(CacheReader &reader)
+{
+	CompileUnitIndex unit;
+	unit.is_indexed = true;
+	unit.offset = reader.get<Dwarf_Off>();
+
+	FunctionIndex::Part &functions = unit.functions;
+	functions.compile_unit.name = reader.getString();
+	functions.compile_unit.comp_dir = reader.getString();
+	functions.compile_unit.die_offset = reader.get<Dwarf_Off>();
+	functions.functions.resize(reader.getCount());
+	for (auto &function : functions.functions)
+	{
+		function.name = reader.getString();
+		function.start_address = reader.get<uint64_t>();
+		function.end_address = reader.get<uint64_t>();
+		function.decl_line = reader.get<uint64_t>();
+		function.die_offset = reader.get<Dwarf_Off>();
+		function.compile_unit = 0;
+	}
+	functions.intervals = readIntervals(reader);
+
+	ScopeIndex::Part &scopes = unit.scopes;
+	scopes.scopes.resize(reader.getCount());
+	for (auto &scope : scopes.scopes)
+	{
+		scope.parent = reader.get<uint32_t>();
+		scope.subprogram = reader.get<uint32_t>();
+		scope.ranges = reader.getArray<PCRange>();
+		scope.children = reader.getArray<uint32_t>();
+		uint64_t variable_count = reader.getCount();
+		scope.variables.reserve(variable_count);
+		for (uint64_t i = 0; i < variable_count; i++)
+		{
+			std::string name = reader.getString();
+			scope.variables.emplace(std::move(name), reader.get<uint32_t>());
+		}
+		scope.frame_base = reader.get<ScopeIndex::Expression>();
+	}
+	scopes.variables = reader.getArray<ScopeIndex::Variable>();
+	scopes.global_variables.resize(reader.getCount());
+	for (auto &global : scopes.global_variables)
+	{
+		global.first = reader.getString();
+		global.second = reader.get<uint32_t>();
+	}
+	scopes.subprogram_intervals = readIntervals(reader);
+	scopes.expressions = reader.getArray<uint8_t>();
+
+	if (reader.get<uint8_t>() != 0)
+	{
+		unit.line_table = std::make_unique<LineTable>();
+		unit.line_table->rows = reader.getArray<LineTable::Row>();
+		unit.line_table->files.resize(reader.getCount());
+		for (auto &file : unit.line_table->files)
+			file = reader.getString();
+	}
+	return unit;
+}
+
+IndexCache::IndexCache(const ELFFile &elf_file, const std::string &directory) :
+	directory(directory),
+	has_build_id(false),
+	executable_size(0),
+	executable_mtime(0)
+{
+	std::string executable_name = elf_file.filePath();
+	struct stat st;
+	if (stat(executable_name.c_str(), &st) == 0)
+	{
+		executable_size = st.st_size;
+		executable_mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+	}
+
+	auto build_id = elf_file.buildId();
+	if (build_id)
+	{
+		has_build_id = true;
+		key = build_id.value();
+		file_path = directory + "/" + key + ".index";
+		return;
+	}
+
+	// Without a build ID, the file can only be told apart from other builds of
+	// the same path by its size and modification time
+	char *absolute_path = realpath(executable_name.c_str(), nullptr);
+	key = (absolute_path != nullptr ? absolute_path : executable_name);
+	free(absolute_path);
+
+	uint64_t hash = 0xcbf29ce484222325;
+	hash = hashBytes(hash, key.data(), key.size());
+	hash = hashBytes(hash, &executable_size, sizeof(executable_size));
+	hash = hashBytes(hash, &executable_mtime, sizeof(executable_mtime));
+	char hash_str[17];
+	snprintf(hash_str, sizeof(hash_str), "%016llx", static_cast<unsigned long long>(hash));
+	file_path = directory + "/path-" + hash_str + ".index";
+}
+
+std::string IndexCache::defaultDirectory()
+{
+	const char *cache_dir = getenv("VDB_CACHE_DIR");
+	if (cache_dir != nullptr && cache_dir[0] != '\0')
+		return cache_dir;
+
+	const char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+	if (xdg_cache_home != nullptr && xdg_cache_home[0] != '\0')
+		return std::string(xdg_cache_home) + "/vdb";
+
+	const char *home = getenv("HOME");
+	if (home != nullptr && home[0] != '\0')
+		return std::string(home) + "/.cache/vdb";
+
+	return "";
+}
+
+std::string IndexCache::path() const
+{
+	return file_path;
+}
+
+expected<std::vector<CompileUnitIndex>, std::string> IndexCache::load() const
+{
+	int file_descriptor = open(file_path.c_str(), O_RDONLY);
+	if (file_descriptor < 0)
+		return make_unexpected("No index cache found at " + file_path);
+
+	struct stat st;
+	if (fstat(file_descriptor, &st) < 0 || st.st_size == 0)
+	{
+		close(file_descriptor);
+		return make_unexpected("Index cache is empty: " + file_path);
+	}
+
+	size_t size = st.st_size;
+	void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+	if (mapping == MAP_FAILED)
+		return make_unexpected("Failed to map index cache: " + file_path);
+
+	auto units = decode(static_cast<const uint8_t *>(mapping), size);
+	munmap(mapping, size);
+	return units;
+}
+
+bool IndexCache::store(const std::vector<CompileUnitIndex> &units) const
+{
+	if (!makeDirectories(directory))
+	{
+		procmsg("[DWARF_ERROR] Failed to create index cache directory %s!\n", directory.c_str());
+		return false;
+	}
+
+	CacheWriter writer;
+	writer.put(CACHE_MAGIC);
+	writer.put(VERSION);
+	writer.putString(key);
+	writer.put(executable_size);
+	writer.put(executable_mtime);
+	writer.put<uint64_t>(units.size());
+	for (const auto &unit : units)
+		writeUnit(writer, unit);
+
+	// Write to a temporary file first, so that concurrent loads never see a
+	// partially written cache
+	std::string temp_path = file_path + ".tmp" + std::to_string(getpid());
+	int file_descriptor = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (file_descriptor < 0)
+	{
+		procmsg("[DWARF_ERROR] Failed to create index cache %s!\n", temp_path.c_str());
+		return false;
+	}
+
+	const std::vector<uint8_t> &data = writer.data();
+	size_t written = 0;
+	while (written < data.size())
+	{
+		ssize_t result = write(file_descriptor, data.data() + written, data.size() - written);
+		if (result <= 0)
+			break;
+		written += result;
+	}
+
+	// The data must reach the disk before the rename does, or a crash could
+	// leave an empty or partial file under the cache's name
+	bool is_synced = (fsync(file_descriptor) == 0);
+	close(file_descriptor);
+
+	if (written < data.size() || !is_synced || rename(temp_path.c_str(), file_path.c_str()) < 0)
+	{
+		procmsg("[DWARF_ERROR] Failed to write index cache %s!\n", file_path.c_str());
+		unlink(temp_path.c_str());
+		return false;
+	}
+
+	procmsg("[DWARF] Wrote %lu compilation units to index cache %s (%lu KiB)\n",
+	        units.size(), file_path.c_str(), data.size() / 1024);
+	return true;
+}
+
+expected<std::vector<CompileUnitIndex>, std::string> IndexCache::decode(const uint8_t *data,
+                                                                        size_t size) const
+{
+	CacheReader reader(data, size);
+
+	auto magic = reader.get<std::array<char, 8>>();
+	uint32_t version = reader.get<uint32_t>();
+	if (reader.hasFailed() || magic != CACHE_MAGIC || version != VERSION)
+		return make_unexpected("Index cache has an unsupported version: " + file_path);
+
+	// Files keyed by a build ID stay valid however the executable is touched
+	std::string cached_key = reader.getString();
+	uint64_t cached_size = reader.get<uint64_t>();
+	int64_t cached_mtime = reader.get<int64_t>();
+	if (cached_key != key ||
+	    (!has_build_id && (cached_size != executable_size || cached_mtime != executable_mtime)))
+	{
+		return make_unexpected("Index cache is out of date: " + file_path);
+	}
+
+	std::vector<CompileUnitIndex> units(reader.getCount());
+	for (auto &unit : units)
+	{
+		unit = readUnit(reader);
+		if (reader.hasFailed())
+			break;
+	}
+	if (reader.hasFailed() || !reader.isAtEnd())
+		return make_unexpected("Index cache is corrupt: " + file_path);
+
+	return units;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+
+#include "../expected.hpp"
+
+#include "DebugLine.hpp"
+#include "FunctionIndex.hpp"
+#include "ScopeIndex.hpp"
+
+using namespace nonstd;
+
+class ELFFile;
+
+// The parts of the indices built from a single compilation unit
+struct CompileUnitIndex
+{
+	bool is_indexed = false;
+	Dwarf_Off offset = 0;
+	FunctionIndex::Part functions;
+	ScopeIndex::Part scopes;
+	std::unique_ptr<LineTable> line_table;
+};
+
+// On-disk copy of the indices built from an executable, so that they don't
+// have to be rebuilt every time it is loaded. Each executable has one cache
+// file, named after its GNU build ID. Executables without one are named after
+// a hash of their path, size and modification time instead, and the file is
+// checked against the size and modification time when it is loaded.
+//
+// Cache files are specific to the machine which wrote them, and are discarded
+// whenever their version or key doesn't match.
+class IndexCache
+{
+public:
+	// Bumped whenever the layout of the cached indices changes
+	static constexpr uint32_t VERSION = 2;
+
+	IndexCache(const ELFFile &elf_file, const std::string &directory);
+
+	// $VDB_CACHE_DIR, $XDG_CACHE_HOME/vdb or ~/.cache/vdb, in that order
+	static std::string defaultDirectory();
+
+	std::string path() const;
+
+	expected<std::vector<CompileUnitIndex>, std::string> load() const;
+	bool store(const std::vector<CompileUnitIndex> &units) const;
+
+private:
+	std::string directory;
+	std::string file_path;
+	// The build ID, or the path if there isn't one
+	std::string key;
+	bool has_build_id;
+	uint64_t executable_size;
+	int64_t executable_mtime;
+
+	expected<std::vector<CompileUnitIndex>, std::string> decode(const uint8_t *data, size_t size) const;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+// Immutable lookup table mapping half-open [low, high) address intervals to
+// values. Intervals may overlap or nest, in which case a lookup returns the
+// enclosing interval with the greatest low address (the innermost one).
+template <typename T>
+class IntervalMap
+{
+public:
+	struct Interval
+	{
+		uint64_t low;
+		uint64_t high;
+		T value;
+	};
+
+	IntervalMap() = default;
+
+	IntervalMap(std::vector<Interval> unsorted_intervals) :
+		intervals(std::move(unsorted_intervals))
+	{
+		std::stable_sort(intervals.begin(), intervals.end(),
+		                 [](const Interval &a, const Interval &b)
+		                 {
+		                     return a.low < b.low;
+		                 });
+
+		// Store the highest high address seen at or before each position.
+		// This bounds how far back a lookup has to search.
+		uint64_t max_high = 0;
+		max_highs.reserve(intervals.size());
+		for (const auto &interval : intervals)
+		{
+			max_high = std::max(max_high, interval.high);
+			max_highs.push_back(max_high);
+		}
+	}
+
+	const T *find(uint64_t address) const
+	{
+		// Find the first interval which starts after the address
+		auto it = std::upper_bound(intervals.begin(), intervals.end(), address,
+		                           [](uint64_t address, const Interval &interval)
+		                           {
+		                               return address < interval.low;
+		                           });
+
+		// Search backwards for the closest interval enclosing the address,
+		// stopping once no earlier interval extends far enough to contain it
+		size_t i = it - intervals.begin();
+		while (i > 0)
+		{
+			--i;
+			if (max_highs[i] <= address)
+				break;
+			if (address < intervals[i].high)
+				return &intervals[i].value;
+		}
+		return nullptr;
+	}
+
+	const std::vector<Interval> &getIntervals() const
+	{
+		return intervals;
+	}
+
+	size_t size() const
+	{
+		return intervals.size();
+	}
+
+private:
+	std::vector<Interval> intervals;
+	std::vector<uint64_t> max_highs;
+};
@@ -0,0 +1,509 @@
+#include "NameTable.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include <libdwarf/dwarf.h>
+
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+// DWARF5 definitions which older versions of libdwarf don't provide
+#ifndef DW_IDX_compile_unit
+#define DW_IDX_compile_unit 0x01
+#define DW_IDX_type_unit 0x02
+#endif
+#ifndef DW_FORM_data16
+#define DW_FORM_data16 0x1e
+#endif
+#ifndef DW_FORM_implicit_const
+#define DW_FORM_implicit_const 0x21
+#endif
+
+template <typename T>
+static bool readFixed(const uint8_t *&data, const uint8_t *end, T &value)
+{
+	if (static_cast<size_t>(end - data) < sizeof(T))
+		return false;
+	memcpy(&value, data, sizeof(T));
+	data += sizeof(T);
+	return true;
+}
+
+static bool readULEB128(const uint8_t *&data, const uint8_t *end, Dwarf_Unsigned &value)
+{
+	value = 0;
+	unsigned int shift = 0;
+	while (data < end)
+	{
+		uint8_t byte = *data++;
+		if (shift < 64)
+			value |= static_cast<Dwarf_Unsigned>(byte & 0x7f) << shift;
+		shift += 7;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+static bool skip(const uint8_t *&data, const uint8_t *end, uint64_t length)
+{
+	if (static_cast<uint64_t>(end - data) < length)
+		return false;
+	data += length;
+	return true;
+}
+
+// Reads an offset whose bounds have already been checked
+static uint64_t offsetAt(const uint8_t *data, uint8_t offset_size)
+{
+	if (offset_size == 4)
+	{
+		uint32_t offset;
+		memcpy(&offset, data, sizeof(offset));
+		return offset;
+	}
+	uint64_t offset;
+	memcpy(&offset, data, sizeof(offset));
+	return offset;
+}
+
+static uint32_t u32At(const uint8_t *data)
+{
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+// Compares a NUL-terminated string in a section without reading past its end
+static bool isSectionString(const uint8_t *section, size_t size, uint64_t offset, const std::string &str)
+{
+	if (offset >= size)
+		return false;
+	const char *section_str = reinterpret_cast<const char *>(section + offset);
+	size_t max_length = size - offset;
+	return (strnlen(section_str, max_length) == str.size() &&
+	        memcmp(section_str, str.data(), str.size()) == 0);
+}
+
+static void sortUnique(std::vector<Dwarf_Off> &offsets)
+{
+	std::sort(offsets.begin(), offsets.end());
+	offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+}
+
+// =============================================================================
+// NameTable
+// =============================================================================
+
+std::shared_ptr<NameTable> NameTable::read(std::shared_ptr<const DebugSections> sections)
+{
+	auto debug_names = sections->sectionData(".debug_names");
+	if (debug_names && debug_names.value().size > 0)
+	{
+		auto debug_str = sections->sectionData(".debug_str");
+		auto table = std::make_shared<DebugNamesTable>(sections, debug_names.value(),
+		                                               debug_str.value_or(ByteSpan()));
+		if (table->isValid())
+			return table;
+		procmsg("[DWARF_ERROR] Ignoring malformed .debug_names section!\n");
+	}
+
+	auto gdb_index = sections->sectionData(".gdb_index");
+	if (gdb_index && gdb_index.value().size > 0)
+	{
+		auto table = std::make_shared<GdbIndexTable>(sections, gdb_index.value());
+		if (table->isValid())
+			return table;
+		procmsg("[DWARF_ERROR] Ignoring unsupported .gdb_index section!\n");
+	}
+	return nullptr;
+}
+
+// =============================================================================
+// DebugNamesTable
+// =============================================================================
+
+DebugNamesTable::DebugNamesTable(std::shared_ptr<const DebugSections> sections, ByteSpan section,
+                                 ByteSpan strings) :
+	sections(std::move(sections)),
+	section(section),
+	strings(strings)
+{
+	const uint8_t *data = section.data;
+	const uint8_t *section_end = data + section.size;
+	while (data < section_end && parseIndex(data, section_end)) {}
+}
+
+bool DebugNamesTable::isValid() const
+{
+	return !indices.empty();
+}
+
+std::vector<Dwarf_Off> DebugNamesTable::findCompileUnits(const std::string &name) const
+{
+	size_t separator = name.rfind("::");
+	std::string base_name = (separator == std::string::npos ? name : name.substr(separator + 2));
+
+	// The hash is of the case folded name, but producers haven't always
+	// folded it, so both are tried
+	uint32_t hashes[2] = {5381, 5381};
+	for (unsigned char c : base_name)
+	{
+		hashes[0] = hashes[0] * 33 + tolower(c);
+		hashes[1] = hashes[1] * 33 + c;
+	}
+	size_t hash_count = (hashes[0] != hashes[1] ? 2 : 1);
+
+	std::vector<Dwarf_Off> cu_offsets;
+	for (const auto &index : indices)
+	{
+		if (index.bucket_count == 0)
+		{
+			// Without a hash table, the names can only be searched in order
+			for (uint32_t i = 0; i < index.name_count; i++)
+			{
+				if (isName(index, i, base_name))
+					readEntries(index, i, cu_offsets);
+			}
+			continue;
+		}
+
+		for (size_t h = 0; h < hash_count; h++)
+		{
+			uint32_t bucket = hashes[h] % index.bucket_count;
+			uint32_t first_name = u32At(index.buckets + static_cast<size_t>(bucket) * 4);
+			if (first_name == 0)
+				continue;
+
+			// Names in a bucket are stored together, starting from one
+			for (uint32_t i = first_name - 1; i < index.name_count; i++)
+			{
+				uint32_t hash = u32At(index.hashes + static_cast<size_t>(i) * 4);
+				if (hash % index.bucket_count != bucket)
+					break;
+				if (hash == hashes[h] && isName(index, i, base_name))
+				{
+					readEntries(index, i, cu_offsets);
+					break;
+				}
+			}
+		}
+	}
+
+	sortUnique(cu_offsets);
+	return cu_offsets;
+}
+
+const char *DebugNamesTable::getSectionName() const
+{
+	return ".debug_names";
+}
+
+bool DebugNamesTable::parseIndex(const uint8_t *&data, const uint8_t *section_end)
+{
+	NameIndex index;
+	index.offset_size = 4;
+
+	uint32_t length;
+	uint64_t unit_length;
+	if (!readFixed(data, section_end, length))
+		return false;
+	unit_length = length;
+	if (length == 0xffffffff)
+	{
+		if (!readFixed(data, section_end, unit_length))
+			return false;
+		index.offset_size = 8;
+	}
+	if (unit_length > static_cast<uint64_t>(section_end - data))
+		return false;
+
+	const uint8_t *unit_end = data + unit_length;
+	const uint8_t *p = data;
+	data = unit_end;
+
+	uint16_t version;
+	uint16_t padding;
+	uint32_t cu_count;
+	uint32_t local_tu_count;
+	uint32_t foreign_tu_count;
+	uint32_t abbrev_table_size;
+	uint32_t augmentation_size;
+	if (!readFixed(p, unit_end, version) || !readFixed(p, unit_end, padding) ||
+	    !readFixed(p, unit_end, cu_count) || !readFixed(p, unit_end, local_tu_count) ||
+	    !readFixed(p, unit_end, foreign_tu_count) || !readFixed(p, unit_end, index.bucket_count) ||
+	    !readFixed(p, unit_end, index.name_count) || !readFixed(p, unit_end, abbrev_table_size) ||
+	    !readFixed(p, unit_end, augmentation_size) || !skip(p, unit_end, augmentation_size))
+	{
+		return false;
+	}
+	if (version != 5)
+		return false;
+
+	if (cu_count > static_cast<uint64_t>(unit_end - p) / index.offset_size)
+		return false;
+	index.cu_offsets.reserve(cu_count);
+	for (uint32_t i = 0; i < cu_count; i++)
+	{
+		if (!skip(p, unit_end, index.offset_size))
+			return false;
+		index.cu_offsets.push_back(offsetAt(p - index.offset_size, index.offset_size));
+	}
+
+	uint64_t name_table_size = static_cast<uint64_t>(index.name_count) * index.offset_size;
+	if (!skip(p, unit_end, static_cast<uint64_t>(local_tu_count) * index.offset_size +
+	                       static_cast<uint64_t>(foreign_tu_count) * 8))
+		return false;
+	index.buckets = p;
+	if (!skip(p, unit_end, static_cast<uint64_t>(index.bucket_count) * 4))
+		return false;
+	// The hashes are left out when there are no buckets
+	index.hashes = p;
+	if (index.bucket_count > 0 && !skip(p, unit_end, static_cast<uint64_t>(index.name_count) * 4))
+		return false;
+	index.string_offsets = p;
+	if (!skip(p, unit_end, name_table_size))
+		return false;
+	index.entry_offsets = p;
+	if (!skip(p, unit_end, name_table_size))
+		return false;
+
+	const uint8_t *abbrev_end = p;
+	if (!skip(abbrev_end, unit_end, abbrev_table_size))
+		return false;
+	while (p < abbrev_end)
+	{
+		Dwarf_Unsigned code;
+		Abbrev abbrev;
+		if (!readULEB128(p, abbrev_end, code))
+			return false;
+		if (code == 0)
+			break;
+		if (!readULEB128(p, abbrev_end, abbrev.tag))
+			return false;
+
+		Dwarf_Unsigned attribute;
+		Dwarf_Unsigned form;
+		do
+		{
+			if (!readULEB128(p, abbrev_end, attribute) || !readULEB128(p, abbrev_end, form))
+				return false;
+			if (form == DW_FORM_implicit_const)
+				return false;
+			if (attribute != 0)
+				abbrev.attributes.emplace_back(attribute, form);
+		} while (attribute != 0 || form != 0);
+
+		index.abbrevs.emplace(code, std::move(abbrev));
+	}
+
+	index.entries = abbrev_end;
+	index.end = unit_end;
+	indices.push_back(std::move(index));
+	return true;
+}
+
+bool DebugNamesTable::isName(const NameIndex &index, uint32_t name, const std::string &str) const
+{
+	uint64_t offset = offsetAt(index.string_offsets + static_cast<size_t>(name) * index.offset_size,
+	                           index.offset_size);
+	return isSectionString(strings.data, strings.size, offset, str);
+}
+
+void DebugNamesTable::readEntries(const NameIndex &index, uint32_t name,
+                                  std::vector<Dwarf_Off> &cu_offsets) const
+{
+	uint64_t offset = offsetAt(index.entry_offsets + static_cast<size_t>(name) * index.offset_size,
+	                           index.offset_size);
+	const uint8_t *p = index.entries;
+	if (!skip(p, index.end, offset))
+		return;
+
+	// The entries of a name end with an abbreviation code of zero
+	Dwarf_Unsigned code;
+	while (readULEB128(p, index.end, code) && code != 0)
+	{
+		auto it = index.abbrevs.find(code);
+		if (it == index.abbrevs.end())
+			return;
+
+		// The compilation unit may be left out if there is only one
+		Dwarf_Unsigned cu = (index.cu_offsets.size() == 1 ? 0 : index.cu_offsets.size());
+		bool is_type_unit = false;
+		for (const auto &attribute : it->second.attributes)
+		{
+			Dwarf_Unsigned value = 0;
+			bool is_read = false;
+			switch (attribute.second)
+			{
+			case DW_FORM_flag_present:
+				value = 1;
+				is_read = true;
+				break;
+			case DW_FORM_data1:
+			case DW_FORM_ref1:
+			case DW_FORM_flag:
+			{
+				uint8_t value8;
+				is_read = readFixed(p, index.end, value8);
+				value = value8;
+				break;
+			}
+			case DW_FORM_data2:
+			case DW_FORM_ref2:
+			{
+				uint16_t value16;
+				is_read = readFixed(p, index.end, value16);
+				value = value16;
+				break;
+			}
+			case DW_FORM_data4:
+			case DW_FORM_ref4:
+			{
+				uint32_t value32;
+				is_read = readFixed(p, index.end, value32);
+				value = value32;
+				break;
+			}
+			case DW_FORM_data8:
+			case DW_FORM_ref8:
+			case DW_FORM_ref_sig8:
+				is_read = readFixed(p, index.end, value);
+				break;
+			case DW_FORM_data16:
+				is_read = skip(p, index.end, 16);
+				break;
+			case DW_FORM_udata:
+			case DW_FORM_ref_udata:
+			case DW_FORM_sdata:
+				is_read = readULEB128(p, index.end, value);
+				break;
+			default:
+				break;
+			}
+			if (!is_read)
+				return;
+
+			if (attribute.first == DW_IDX_compile_unit)
+				cu = value;
+			else if (attribute.first == DW_IDX_type_unit)
+				is_type_unit = true;
+		}
+
+		// Type units aren't read by VDB
+		if (!is_type_unit && cu < index.cu_offsets.size())
+			cu_offsets.push_back(index.cu_offsets[cu]);
+	}
+}
+
+// =============================================================================
+// GdbIndexTable
+// =============================================================================
+
+GdbIndexTable::GdbIndexTable(std::shared_ptr<const DebugSections> sections, ByteSpan section) :
+	sections(std::move(sections)),
+	section(section),
+	version(0),
+	symbols(nullptr),
+	symbol_count(0),
+	constant_pool(nullptr),
+	constant_pool_size(0)
+{
+	// Versions before 7 were written with known bugs. Version 9 adds the
+	// shortcut table, which moves the constant pool's offset along.
+	const uint8_t *data = section.data;
+	size_t size = section.size;
+	if (size < 7 * sizeof(uint32_t))
+		return;
+	uint32_t section_version = u32At(data);
+	if (section_version < 7 || section_version > 9)
+		return;
+
+	uint32_t cu_list_offset = u32At(data + 4);
+	uint32_t types_offset = u32At(data + 8);
+	uint32_t symbols_offset = u32At(data + 16);
+	uint32_t symbols_end = u32At(data + 20);
+	uint32_t pool_offset = u32At(data + (section_version >= 9 ? 24 : 20));
+	// The areas are laid out in order, so each offset bounds the area before
+	// it, and the last is bounded by the section
+	if (cu_list_offset > types_offset || types_offset > symbols_offset ||
+	    symbols_offset > symbols_end || symbols_end > pool_offset || pool_offset > size)
+	{
+		return;
+	}
+
+	// The symbol table is probed with a mask, so must be a power of two
+	uint32_t slot_count = (symbols_end - symbols_offset) / 8;
+	if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0)
+		return;
+
+	for (uint32_t offset = cu_list_offset; offset + 16 <= types_offset; offset += 16)
+	{
+		uint64_t cu_offset;
+		memcpy(&cu_offset, data + offset, sizeof(cu_offset));
+		cu_offsets.push_back(cu_offset);
+	}
+
+	version = section_version;
+	symbols = data + symbols_offset;
+	symbol_count = slot_count;
+	constant_pool = data + pool_offset;
+	constant_pool_size = size - pool_offset;
+}
+
+bool GdbIndexTable::isValid() const
+{
+	return version != 0;
+}
+
+std::vector<Dwarf_Off> GdbIndexTable::findCompileUnits(const std::string &name) const
+{
+	std::vector<Dwarf_Off> result;
+	if (!isValid())
+		return result;
+
+	// The hash used by gdb's mapped_index_string_hash
+	uint32_t hash = 0;
+	for (unsigned char c : name)
+		hash = hash * 67 + tolower(c) - 113;
+
+	uint32_t mask = symbol_count - 1;
+	uint32_t slot = hash & mask;
+	uint32_t step = ((hash * 17) & mask) | 1;
+	for (uint32_t probes = 0; probes < symbol_count; probes++, slot = (slot + step) & mask)
+	{
+		uint32_t name_offset = u32At(symbols + slot * 8);
+		uint32_t vector_offset = u32At(symbols + slot * 8 + 4);
+		if (name_offset == 0 && vector_offset == 0)
+			break;
+
+		if (!isSectionString(constant_pool, constant_pool_size, name_offset, name))
+			continue;
+
+		// The CU vector is a count followed by the index of each unit, with
+		// the symbol's kind in the upper bits
+		if (vector_offset + 4 > constant_pool_size)
+			break;
+		uint32_t count = u32At(constant_pool + vector_offset);
+		if (count > (constant_pool_size - vector_offset - 4) / 4)
+			break;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t cu = u32At(constant_pool + vector_offset + 4 + i * 4) & 0x00ffffff;
+			if (cu < cu_offsets.size())
+				result.push_back(cu_offsets[cu]);
+		}
+		break;
+	}
+
+	sortUnique(result);
+	return result;
+}
+
+const char *GdbIndexTable::getSectionName() const
+{
+	return ".gdb_index";
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+
+#include "DebugSections.hpp"
+
+// Name lookups through the accelerator tables written by the compiler
+// (.debug_names, DWARF5) or the linker (.gdb_index). Either maps the name of a
+// function, variable or type to the compilation units which declare it, so
+// that only those units have to be read.
+class NameTable
+{
+public:
+	virtual ~NameTable() = default;
+
+	// Reads whichever table the executable has, preferring .debug_names.
+	// Returns nullptr if it has neither, or if the table can't be parsed. The
+	// table reads the sections in place, so keeps them alive.
+	static std::shared_ptr<NameTable> read(std::shared_ptr<const DebugSections> sections);
+
+	// Gets the offsets of the compilation units which declare a name, which
+	// may be qualified ("ns::name"). .debug_names only records unqualified
+	// names, so it may also return units declaring the name elsewhere.
+	virtual std::vector<Dwarf_Off> findCompileUnits(const std::string &name) const = 0;
+
+	virtual const char *getSectionName() const = 0;
+};
+
+class DebugNamesTable : public NameTable
+{
+public:
+	DebugNamesTable(std::shared_ptr<const DebugSections> sections, ByteSpan section, ByteSpan strings);
+
+	DebugNamesTable(const DebugNamesTable &other) = delete;
+	DebugNamesTable &operator=(const DebugNamesTable &other) = delete;
+
+	// Whether at least one name index in the section could be parsed
+	bool isValid() const;
+
+	virtual std::vector<Dwarf_Off> findCompileUnits(const std::string &name) const override;
+	virtual const char *getSectionName() const override;
+
+private:
+	struct Abbrev
+	{
+		Dwarf_Unsigned tag;
+		// Pairs of DW_IDX_* attributes and their forms
+		std::vector<std::pair<Dwarf_Unsigned, Dwarf_Unsigned>> attributes;
+	};
+
+	// Each compilation unit may have a name index of its own, unless the
+	// linker merged them
+	struct NameIndex
+	{
+		uint8_t offset_size;
+		std::vector<Dwarf_Off> cu_offsets;
+		uint32_t bucket_count;
+		uint32_t name_count;
+		const uint8_t *buckets;
+		const uint8_t *hashes;
+		const uint8_t *string_offsets;
+		const uint8_t *entry_offsets;
+		const uint8_t *entries;
+		const uint8_t *end;
+		std::unordered_map<Dwarf_Unsigned, Abbrev> abbrevs;
+	};
+
+	std::shared_ptr<const DebugSections> sections;
+	ByteSpan section;
+	ByteSpan strings;
+	std::vector<NameIndex> indices;
+
+	bool parseIndex(const uint8_t *&data, const uint8_t *section_end);
+	bool isName(const NameIndex &index, uint32_t name, const std::string &str) const;
+	void readEntries(const NameIndex &index, uint32_t name, std::vector<Dwarf_Off> &cu_offsets) const;
+};
+
+class GdbIndexTable : public NameTable
+{
+public:
+	GdbIndexTable(std::shared_ptr<const DebugSections> sections, ByteSpan section);
+
+	GdbIndexTable(const GdbIndexTable &other) = delete;
+	GdbIndexTable &operator=(const GdbIndexTable &other) = delete;
+
+	bool isValid() const;
+
+	virtual std::vector<Dwarf_Off> findCompileUnits(const std::string &name) const override;
+	virtual const char *getSectionName() const override;
+
+private:
+	std::shared_ptr<const DebugSections> sections;
+	ByteSpan section;
+	uint32_t version;
+	std::vector<Dwarf_Off> cu_offsets;
+	const uint8_t *symbols;
+	uint32_t symbol_count;
+	const uint8_t *constant_pool;
+	size_t constant_pool_size;
+};
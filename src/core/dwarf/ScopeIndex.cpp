@@ -0,0 +1,256 @@
+#include "ScopeIndex.hpp"
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+static bool containsPC(const std::vector<PCRange> &ranges, uint64_t pc)
+{
+	for (const auto &range : ranges)
+	{
+		if (pc >= range.low_pc && pc < range.high_pc)
+			return true;
+	}
+	return false;
+}
+
+ScopeIndex::ScopeIndex(std::vector<Part> parts)
+{
+	std::vector<IntervalMap<uint32_t>::Interval> subprogram_intervals;
+
+	// Scopes, variables and expressions are numbered from zero within each
+	// part, so are offset by the size of everything merged before them
+	for (auto &part : parts)
+	{
+		uint32_t first_scope = scopes.size();
+		uint32_t first_variable = variables.size();
+		uint32_t first_expression = expressions.size();
+		auto rebaseScope = [&](uint32_t scope)
+		{
+			return (scope != NO_SCOPE ? scope + first_scope : NO_SCOPE);
+		};
+
+		for (auto &scope : part.scopes)
+		{
+			scope.parent = rebaseScope(scope.parent);
+			scope.subprogram = rebaseScope(scope.subprogram);
+			for (auto &child : scope.children)
+				child += first_scope;
+			for (auto &variable : scope.variables)
+				variable.second += first_variable;
+			scope.frame_base.offset += first_expression;
+			scopes.push_back(std::move(scope));
+		}
+		for (auto &variable : part.variables)
+		{
+			variable.location.offset += first_expression;
+			variables.push_back(variable);
+		}
+		for (const auto &global : part.global_variables)
+			global_variables.emplace(global.first, global.second + first_variable);
+		for (const auto &interval : part.subprogram_intervals)
+			subprogram_intervals.push_back({interval.low, interval.high, interval.value + first_scope});
+		expressions.insert(expressions.end(), part.expressions.begin(), part.expressions.end());
+	}
+
+	subprogram_ranges = IntervalMap<uint32_t>(std::move(subprogram_intervals));
+
+	procmsg("[DWARF] Indexed %lu variables in %lu scopes\n", variables.size(), scopes.size());
+}
+
+ScopeIndex::Part ScopeIndex::indexCompileUnit(DwarfInfoReader &reader, DIE &cu)
+{
+	Part part;
+	uint32_t cu_scope = addScope(cu, NO_SCOPE, NO_SCOPE, {}, part);
+	indexChildren(reader, cu, cu_scope, "", part);
+	return part;
+}
+
+expected<ScopeIndex::VariableLocExpr, std::string> ScopeIndex::getVarLocExpr(const std::string &var_name,
+                                                                             uint64_t pc) const
+{
+	// Search outwards from the innermost scope, so that variables shadow
+	// those with the same name in enclosing scopes
+	for (uint32_t scope = findInnermostScope(pc); scope != NO_SCOPE; scope = scopes[scope].parent)
+	{
+		auto it = scopes[scope].variables.find(var_name);
+		if (it != scopes[scope].variables.end())
+			return toLocExpr(variables[it->second], scope);
+	}
+
+	// Then look for the variable globally if it isn't found locally
+	return getGlobalVarLocExpr(var_name);
+}
+
+expected<ScopeIndex::VariableLocExpr, std::string> ScopeIndex::getGlobalVarLocExpr(const std::string &var_name) const
+{
+	auto it = global_variables.find(var_name);
+	if (it != global_variables.end())
+		return toLocExpr(variables[it->second], NO_SCOPE);
+
+	return make_unexpected("Could not determine location expression: " + var_name);
+}
+
+void ScopeIndex::indexChildren(DwarfInfoReader &reader, DIE &die, uint32_t scope,
+                               const std::string &name_prefix, Part &part)
+{
+	// Only the subtrees which can declare variables are walked. The scope and
+	// name prefix change with each level, so nested scopes recurse explicitly.
+	reader.visitChildren(die, [&](DIE &child)
+	{
+		Dwarf_Half tag = child.getTag();
+		if (tag == DW_TAG_variable || tag == DW_TAG_formal_parameter)
+		{
+			addVariable(reader, child, scope, name_prefix, part);
+		}
+		else if (tag == DW_TAG_subprogram)
+		{
+			// Declarations and abstract instances of inlined functions have no
+			// code, and so can never enclose a PC
+			std::vector<PCRange> ranges = child.getPCRanges();
+			if (ranges.empty())
+				return SKIP_CHILDREN;
+
+			uint32_t sub_scope = addScope(child, scope, part.scopes.size(), ranges, part);
+			for (const auto &range : ranges)
+			{
+				// Functions discarded by the linker are left with a low PC of zero
+				if (range.low_pc != 0 && range.low_pc < range.high_pc)
+					part.subprogram_intervals.push_back({range.low_pc, range.high_pc, sub_scope});
+			}
+			indexChildren(reader, child, sub_scope, "", part);
+		}
+		else if (tag == DW_TAG_lexical_block)
+		{
+			uint32_t block_scope = addScope(child, scope, part.scopes[scope].subprogram,
+			                                child.getPCRanges(), part);
+			part.scopes[scope].children.push_back(block_scope);
+			indexChildren(reader, child, block_scope, "", part);
+		}
+		else if (tag == DW_TAG_namespace)
+		{
+			// Namespaces don't create a new lexical scope, but qualify the names
+			// of the variables declared within them
+			char default_name[] = "(anonymous namespace)";
+			std::string name = child.getAttributeValue<DW_AT_name>().value_or(default_name);
+			indexChildren(reader, child, scope, name_prefix + name + "::", part);
+		}
+		return SKIP_CHILDREN;
+	});
+}
+
+uint32_t ScopeIndex::addScope(DIE &die, uint32_t parent, uint32_t subprogram,
+                              std::vector<PCRange> ranges, Part &part)
+{
+	Scope scope;
+	scope.parent = parent;
+	scope.subprogram = subprogram;
+	scope.ranges = std::move(ranges);
+	scope.frame_base = addExpression(
+		die.getAttributeValue<DW_AT_frame_base>().value_or(ExprLoc{0, nullptr}), part);
+	part.scopes.push_back(std::move(scope));
+	return part.scopes.size() - 1;
+}
+
+void ScopeIndex::addVariable(DwarfInfoReader &reader, DIE &die, uint32_t scope,
+                             const std::string &name_prefix, Part &part)
+{
+	// Out-of-line definitions of static members carry their name and type on
+	// the declaration
+	auto [expected_name, expected_type, specification] =
+		die.getAttributeValues<DW_AT_name, DW_AT_type, DW_AT_specification>();
+	if (specification)
+	{
+		std::unique_ptr<DIE> decl = reader.getDIEByOffset(specification.value());
+		if (decl != nullptr)
+			std::tie(expected_name, expected_type) = decl->getAttributeValues<DW_AT_name, DW_AT_type>();
+	}
+	if (!expected_name || !expected_type)
+		return;
+
+	// Only simple location expressions are supported, so location lists (and
+	// variables which have been optimized out) are stored without one
+	ExprLoc location = ExprLoc{0, nullptr};
+	if (die.getAttributeForm<DW_AT_location>() == DW_FORM_exprloc)
+		location = die.getAttributeValue<DW_AT_location>().value_or(location);
+
+	Variable variable;
+	variable.type_offset = expected_type.value();
+	variable.location = addExpression(location, part);
+
+	std::string name = name_prefix + expected_name.value();
+	bool is_global = (part.scopes[scope].subprogram == NO_SCOPE);
+	if (is_global)
+	{
+		// Declarations of variables defined in another compilation unit have
+		// no location, and must not hide the definition
+		if (variable.location.length == 0)
+			return;
+		part.variables.push_back(variable);
+		part.global_variables.emplace_back(name, part.variables.size() - 1);
+	}
+	else
+	{
+		part.variables.push_back(variable);
+	}
+	part.scopes[scope].variables.emplace(name, part.variables.size() - 1);
+}
+
+ScopeIndex::Expression ScopeIndex::addExpression(const ExprLoc &expr, Part &part)
+{
+	Expression expression;
+	expression.offset = part.expressions.size();
+	expression.length = expr.length;
+
+	const uint8_t *bytes = static_cast<const uint8_t *>(expr.ptr);
+	part.expressions.insert(part.expressions.end(), bytes, bytes + expr.length);
+	return expression;
+}
+
+uint32_t ScopeIndex::findInnermostScope(uint64_t pc) const
+{
+	const uint32_t *subprogram = subprogram_ranges.find(pc);
+	if (subprogram == nullptr)
+		return NO_SCOPE;
+
+	// Descend through the nested lexical blocks enclosing the PC
+	uint32_t scope = *subprogram;
+	bool descended = true;
+	while (descended)
+	{
+		descended = false;
+		for (uint32_t child : scopes[scope].children)
+		{
+			if (containsPC(scopes[child].ranges, pc))
+			{
+				scope = child;
+				descended = true;
+				break;
+			}
+		}
+	}
+	return scope;
+}
+
+ScopeIndex::VariableLocExpr ScopeIndex::toLocExpr(const Variable &variable, uint32_t scope) const
+{
+	VariableLocExpr loc_expr;
+	loc_expr.frame_base = 0;
+	loc_expr.location_op = 0;
+	loc_expr.location_param = nullptr;
+	loc_expr.type_offset = variable.type_offset;
+
+	// Local variables are addressed relative to their subprogram's frame base
+	if (scope != NO_SCOPE && scopes[scope].subprogram != NO_SCOPE)
+	{
+		const Expression &frame_base = scopes[scopes[scope].subprogram].frame_base;
+		if (frame_base.length > 0)
+			loc_expr.frame_base = expressions[frame_base.offset];
+	}
+
+	if (variable.location.length > 0)
+	{
+		loc_expr.location_op = expressions[variable.location.offset];
+		loc_expr.location_param = expressions.data() + variable.location.offset + 1;
+	}
+	return loc_expr;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libdwarf/libdwarf.h>
+#include <libdwarf/dwarf.h>
+
+#include "../expected.hpp"
+
+#include "DwarfReader.hpp"
+#include "IntervalMap.hpp"
+
+using namespace nonstd;
+
+// Tree of the lexical scopes in a program (compilation units, subprograms and
+// lexical blocks) along with the variables declared directly within each.
+// Variables are found by locating the innermost scope enclosing a PC and then
+// probing each scope's name table on the way back up to the global scope.
+class ScopeIndex
+{
+public:
+	struct VariableLocExpr
+	{
+		uint8_t frame_base;
+		uint8_t location_op;
+		const uint8_t *location_param;
+		Dwarf_Off type_offset;
+	};
+
+	// A location expression, stored in the index's own expression buffer so
+	// that it outlives the libdwarf instance it was read with
+	struct Expression
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct Variable
+	{
+		Dwarf_Off type_offset;
+		Expression location;
+	};
+
+	struct Scope
+	{
+		uint32_t parent;
+		// The subprogram which owns the stack frame of this scope
+		uint32_t subprogram;
+		std::vector<PCRange> ranges;
+		std::vector<uint32_t> children;
+		std::unordered_map<std::string, uint32_t> variables;
+		Expression frame_base;
+	};
+
+	// The scopes of a single compilation unit. Parts can be built independently
+	// of one another, and are then merged into an index.
+	struct Part
+	{
+		std::vector<Scope> scopes;
+		std::vector<Variable> variables;
+		std::vector<std::pair<std::string, uint32_t>> global_variables;
+		std::vector<IntervalMap<uint32_t>::Interval> subprogram_intervals;
+		std::vector<uint8_t> expressions;
+	};
+
+	ScopeIndex(std::vector<Part> parts);
+
+	static Part indexCompileUnit(DwarfInfoReader &reader, DIE &cu);
+
+	expected<VariableLocExpr, std::string> getVarLocExpr(const std::string &var_name,
+	                                                     uint64_t pc) const;
+	expected<VariableLocExpr, std::string> getGlobalVarLocExpr(const std::string &var_name) const;
+
+private:
+	static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+	std::vector<Scope> scopes;
+	std::vector<Variable> variables;
+	std::unordered_map<std::string, uint32_t> global_variables;
+	IntervalMap<uint32_t> subprogram_ranges;
+	std::vector<uint8_t> expressions;
+
+	static void indexChildren(DwarfInfoReader &reader, DIE &die, uint32_t scope,
+	                          const std::string &name_prefix, Part &part);
+	static uint32_t addScope(DIE &die, uint32_t parent, uint32_t subprogram,
+	                         std::vector<PCRange> ranges, Part &part);
+	static void addVariable(DwarfInfoReader &reader, DIE &die, uint32_t scope,
+	                        const std::string &name_prefix, Part &part);
+	static Expression addExpression(const ExprLoc &expr, Part &part);
+
+	uint32_t findInnermostScope(uint64_t pc) const;
+	VariableLocExpr toLocExpr(const Variable &variable, uint32_t scope) const;
+};
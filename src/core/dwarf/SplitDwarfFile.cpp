@@ -0,0 +1,75 @@
+#include "SplitDwarfFile.hpp"
+
+#include <cstring>
+
+// FOWARD DECLARATION [TODO: REMOVE]
+void procmsg(const char* format, ...);
+
+SplitDwarfFile::SplitDwarfFile(std::shared_ptr<ELFFile> elf_file, Dwarf_Debug executable_dbg,
+                               Dwarf_Handler error_handler) :
+	elf_file(elf_file),
+	sections(std::make_shared<DebugSections>(elf_file, 1)),
+	is_valid(false),
+	is_package(sections->sectionData(".debug_cu_index").has_value())
+{
+	if (sections->initDwarf(error_handler, nullptr, &dbg, nullptr) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Failed to read split DWARF from %s!\n", elf_file->filePath().c_str());
+		return;
+	}
+
+	// Addresses are stored in the executable's .debug_addr section rather
+	// than in the split units
+	if (dwarf_set_tied_dbg(dbg, executable_dbg, nullptr) != DW_DLV_OK)
+	{
+		procmsg("[DWARF_ERROR] Failed to tie %s to the executable!\n", elf_file->filePath().c_str());
+		dwarf_object_finish(dbg, nullptr);
+		return;
+	}
+
+	debug_info = std::make_shared<DwarfInfoReader>(dbg);
+	is_valid = true;
+}
+
+SplitDwarfFile::~SplitDwarfFile()
+{
+	if (is_valid)
+		dwarf_object_finish(dbg, nullptr);
+}
+
+bool SplitDwarfFile::isValid() const
+{
+	return is_valid;
+}
+
+std::unique_ptr<DIE> SplitDwarfFile::findCompileUnit(uint64_t dwo_id)
+{
+	if (!is_valid)
+		return nullptr;
+
+	// Packages index their units by DWO ID, which is stored as an 8-byte
+	// signature in the byte order of the target
+	if (is_package)
+	{
+		Dwarf_Sig8 signature;
+		memcpy(signature.signature, &dwo_id, sizeof(signature.signature));
+		Dwarf_Die die;
+		if (dwarf_die_from_hash_signature(dbg, &signature, "cu", &die, nullptr) != DW_DLV_OK)
+			return nullptr;
+		return std::make_unique<DIE>(dbg, die);
+	}
+
+	std::vector<DIE> compile_units = debug_info->getCompileUnits();
+	for (const auto &cu : compile_units)
+	{
+		auto cu_dwo_id = cu.getAttributeValue<DW_AT_GNU_dwo_id>();
+		if (!cu_dwo_id || cu_dwo_id.value() == dwo_id || compile_units.size() == 1)
+			return std::make_unique<DIE>(cu);
+	}
+	return nullptr;
+}
+
+std::shared_ptr<DwarfInfoReader> SplitDwarfFile::info()
+{
+	return debug_info;
+}
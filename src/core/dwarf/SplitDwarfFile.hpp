@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#include <libdwarf/libdwarf.h>
+
+#include "../ELFFile.hpp"
+
+#include "DebugSections.hpp"
+#include "DIE.hpp"
+#include "DwarfReader.hpp"
+
+// A .dwo file, or a .dwp package of them, holding the DIEs of compilation
+// units built with -gsplit-dwarf. Only the skeletons of these units are in
+// the executable, along with their line tables and the addresses their DIEs
+// refer to. The file is read by a libdwarf instance of its own, which is tied
+// to the executable's so that those addresses can be resolved.
+class SplitDwarfFile
+{
+public:
+	SplitDwarfFile(std::shared_ptr<ELFFile> elf_file, Dwarf_Debug executable_dbg,
+	               Dwarf_Handler error_handler);
+	~SplitDwarfFile();
+
+	SplitDwarfFile(const SplitDwarfFile &other) = delete;
+	SplitDwarfFile &operator=(const SplitDwarfFile &other) = delete;
+
+	bool isValid() const;
+
+	// Gets the split unit matching a skeleton's DWO ID. A .dwo file holds a
+	// single unit, which is returned whatever its ID.
+	std::unique_ptr<DIE> findCompileUnit(uint64_t dwo_id);
+
+	std::shared_ptr<DwarfInfoReader> info();
+
+private:
+	std::shared_ptr<ELFFile> elf_file;
+	std::shared_ptr<DebugSections> sections;
+	Dwarf_Debug dbg;
+	bool is_valid;
+	bool is_package;
+
+	std::shared_ptr<DwarfInfoReader> debug_info = nullptr;
+};
@@ -1,68 +1,65 @@
 #include "ValueDeducer.hpp"
 
-#include <sys/ptrace.h>
-
+#include <algorithm>
 #include <cmath>
 #include <cassert>
+#include <cstring>
 
 // FOWARD DECLARATION [TODO: REMOVE]
 void procmsg(const char* format, ...);
 
-ValueDeducer::ValueDeducer(pid_t target_pid, std::shared_ptr<DwarfDebug> debug_data)
+ValueDeducer::ValueDeducer(ProcessTracer &tracer, std::shared_ptr<DwarfInfoReader> debug_info) :
+	tracer(tracer),
+	debug_info(debug_info)
 {
-	this->target_pid = target_pid;
-	this->debug_data = debug_data;
 }
 
 std::string ValueDeducer::deduce(uint64_t address, DIE &type_die)
 {
-	if (type_die.getTagName() == "DW_TAG_base_type")
+	switch (type_die.getTag())
 	{
+	case DW_TAG_base_type:
 		return deduceBase(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_pointer_type")
-	{
+	case DW_TAG_pointer_type:
 		return deducePointer(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_reference_type")
-	{
+	case DW_TAG_reference_type:
 		return deduceReference(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_array_type")
-	{
+	case DW_TAG_array_type:
 		return deduceArray(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_structure_type")
-	{
+	case DW_TAG_structure_type:
 		return deduceStructure(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_class_type")
-	{
+	case DW_TAG_class_type:
 		return deduceClass(address, type_die);
-	}
-	else if (type_die.getTagName() == "DW_TAG_const_type")
-	{
+	case DW_TAG_const_type:
 		return deduceConst(address, type_die);
-	}
-	else
-	{
+	default:
 		return "Type cannot be deduced";
 	}
 }
 
 std::string ValueDeducer::deduceBase(uint64_t address, const DIE &base_die)
 {
-	assert(base_die.getTagName() == "DW_TAG_base_type");
+	assert(base_die.getTag() == DW_TAG_base_type);
+
+	// Only the bytes of the value are read
+	auto byte_size_opt = base_die.getAttributeValue<DW_AT_byte_size>();
+	if (!byte_size_opt.has_value())
+		return "Could not determine variable encoding/byte size";
 
 	// Get the data at the specified target process address
-	uint64_t data = ptrace(PTRACE_PEEKDATA, target_pid, address, 0);
+	auto data = readData(address, byte_size_opt.value());
+	if (!data.has_value())
+		return data.error();
+	return formatBase(data.value(), base_die);
+}
 
-	// Use the encoding and byte size to determine the data's type
-	auto encoding_opt = base_die.getAttributeValue<DW_AT_encoding>();
-	auto byte_size_opt = base_die.getAttributeValue<DW_AT_byte_size>();
+std::string ValueDeducer::formatBase(uint64_t data, const DIE &base_die)
+{
+	auto [encoding_opt, byte_size_opt] = base_die.getAttributeValues<DW_AT_encoding, DW_AT_byte_size>();
 	if (!encoding_opt.has_value() || !byte_size_opt.has_value())
 		return "Could not determine variable encoding/byte size";
 
+	// Use the encoding and byte size to determine the data's type
 	Dwarf_Unsigned encoding = encoding_opt.value();
 	Dwarf_Unsigned byte_size = byte_size_opt.value();
 	
@@ -177,28 +174,32 @@ std::string ValueDeducer::deduceBase(uint64_t address, const DIE &base_die)
 std::string ValueDeducer::deducePointer(uint64_t address, const DIE &pointer_die)
 {
 	Dwarf_Off type_offset = pointer_die.getAttributeValue<DW_AT_type>().value();
-	DIE type_die = *(debug_data->info()->getDIEByOffset(type_offset));
+	DIE type_die = *(debug_info->getDIEByOffset(type_offset));
 
-	uint64_t new_address = ptrace(PTRACE_PEEKDATA, target_pid, address, 0);
-	return deduce(new_address, type_die);
+	auto new_address = readData(address, sizeof(uint64_t));
+	if (!new_address.has_value())
+		return new_address.error();
+	return deduce(new_address.value(), type_die);
 }
 
 std::string ValueDeducer::deduceReference(uint64_t address, const DIE &ref_die)
 {
 	Dwarf_Off type_offset = ref_die.getAttributeValue<DW_AT_type>().value();
-	DIE type_die = *(debug_data->info()->getDIEByOffset(type_offset));
+	DIE type_die = *(debug_info->getDIEByOffset(type_offset));
 
-	uint64_t new_address = ptrace(PTRACE_PEEKDATA, target_pid, address, 0);
-	return deduce(new_address, type_die);
+	auto new_address = readData(address, sizeof(uint64_t));
+	if (!new_address.has_value())
+		return new_address.error();
+	return deduce(new_address.value(), type_die);
 }
 
 std::string ValueDeducer::deduceArray(uint64_t address, DIE &array_die)
 {
-	assert(array_die.getTagName() == "DW_TAG_array_type");
+	assert(array_die.getTag() == DW_TAG_array_type);
 
 	// Get the type of the array
 	Dwarf_Off type_offset = array_die.getAttributeValue<DW_AT_type>().value();
-	DIE type_die = *(debug_data->info()->getDIEByOffset(type_offset));
+	DIE type_die = *(debug_info->getDIEByOffset(type_offset));
 
 	// Find the subrange child DIE to determine the upper bound of the array
 	uint64_t array_length = 0;
@@ -206,7 +207,7 @@ std::string ValueDeducer::deduceArray(uint64_t address, DIE &array_die)
 	std::vector<DIE> children = array_die.getChildren();
 	for (auto &child : children)
 	{
-		if (child.getTagName() == "DW_TAG_subrange_type")
+		if (child.getTag() == DW_TAG_subrange_type)
 		{
 			array_length = child.getAttributeValue<DW_AT_upper_bound>().value();
 			found_array_length = true;
@@ -214,16 +215,36 @@ std::string ValueDeducer::deduceArray(uint64_t address, DIE &array_die)
 	}
 	if (!found_array_length) return "Could not determine array length";
 
-	// Deduce the array's contents
-	std::string values = "{";
 	uint64_t type_byte_size = type_die.getAttributeValue<DW_AT_byte_size>().value();
 	uint64_t array_byte_size = type_byte_size * (array_length + 1);
+
+	// Arrays of base types are read in one go, rather than an element at a
+	// time
+	std::vector<uint8_t> elements;
+	if (type_die.getTag() == DW_TAG_base_type && type_byte_size <= sizeof(uint64_t))
+	{
+		elements.resize(array_byte_size);
+		if (!tracer.readMemory(address, elements.data(), elements.size()).has_value())
+			elements.clear();
+	}
+
+	// Deduce the array's contents
+	std::string values = "{";
 	for (uint64_t i = 0; i < array_byte_size; i += type_byte_size)
 	{
 		// Add a comma before adding the next value
 		if (i > 0) values += ", ";
 
-		values += deduce(address + i, type_die);
+		if (!elements.empty())
+		{
+			uint64_t data = 0;
+			memcpy(&data, elements.data() + i, type_byte_size);
+			values += formatBase(data, type_die);
+		}
+		else
+		{
+			values += deduce(address + i, type_die);
+		}
 	}
 	values += "}";
 
@@ -238,20 +259,19 @@ std::string ValueDeducer::deduceStructure(uint64_t address, DIE &struct_die)
 	std::vector<DIE> children = struct_die.getChildren();
 	for (auto &child : children)
 	{
-		if (child.getTagName() == "DW_TAG_member")
+		if (child.getTag() == DW_TAG_member)
 		{
 			// Add a comma before adding the next member variable
 			if (counter++ > 0) values += ", ";
 
-			Dwarf_Off type_offset = child.getAttributeValue<DW_AT_type>().value();
-			Dwarf_Unsigned member_location = child.getAttributeValue<DW_AT_data_member_location>().value();
-			uint64_t member_address = address + member_location;
-			std::string name = child.getAttributeValue<DW_AT_name>().value();
+			auto [type_offset, member_location, name] =
+				child.getAttributeValues<DW_AT_type, DW_AT_data_member_location, DW_AT_name>();
+			uint64_t member_address = address + member_location.value();
 
 			// Append member variable name and value to the return string
-			values += name;
+			values += name.value();
 			values += "=";
-			values += deduce(member_address, *(debug_data->info()->getDIEByOffset(type_offset)));
+			values += deduce(member_address, *(debug_info->getDIEByOffset(type_offset.value())));
 		}
 	}
 
@@ -262,7 +282,7 @@ std::string ValueDeducer::deduceStructure(uint64_t address, DIE &struct_die)
 
 std::string ValueDeducer::deduceClass(uint64_t address, DIE &class_die)
 {
-	assert(class_die.getTagName() == "DW_TAG_class_type");
+	assert(class_die.getTag() == DW_TAG_class_type);
 
 	std::string values = "{";
 
@@ -270,20 +290,19 @@ std::string ValueDeducer::deduceClass(uint64_t address, DIE &class_die)
 	std::vector<DIE> children = class_die.getChildren();
 	for (auto &child : children)
 	{
-		if (child.getTagName() == "DW_TAG_member")
+		if (child.getTag() == DW_TAG_member)
 		{
 			// Add a comma before adding the next member variable
 			if (counter++ > 0) values += ", ";
 
-			Dwarf_Off type_offset = child.getAttributeValue<DW_AT_type>().value();
-			Dwarf_Unsigned member_location = child.getAttributeValue<DW_AT_data_member_location>().value();
-			uint64_t member_address = address + member_location;
-			std::string name = child.getAttributeValue<DW_AT_name>().value();
+			auto [type_offset, member_location, name] =
+				child.getAttributeValues<DW_AT_type, DW_AT_data_member_location, DW_AT_name>();
+			uint64_t member_address = address + member_location.value();
 
 			// Append member variable name and value to the return string
-			values += name;
+			values += name.value();
 			values += "=";
-			values += deduce(member_address, *(debug_data->info()->getDIEByOffset(type_offset)));
+			values += deduce(member_address, *(debug_info->getDIEByOffset(type_offset.value())));
 		}
 	}
 
@@ -296,10 +315,19 @@ std::string ValueDeducer::deduceConst(uint64_t address, const DIE &const_die)
 {
 	// Get the type
 	Dwarf_Off type_offset = const_die.getAttributeValue<DW_AT_type>().value();
-	DIE type_die = *(debug_data->info()->getDIEByOffset(type_offset));
+	DIE type_die = *(debug_info->getDIEByOffset(type_offset));
 	return deduce(address, type_die);
 }
 
+expected<uint64_t, std::string> ValueDeducer::readData(uint64_t address, uint64_t byte_size)
+{
+	uint64_t data = 0;
+	auto result = tracer.readMemory(address, &data, std::min<uint64_t>(byte_size, sizeof(data)));
+	if (!result.has_value())
+		return make_unexpected(result.error());
+	return data;
+}
+
 float ValueDeducer::decodeFloat(uint64_t data)
 {
 	// Decoding according to IEEE-754 single-precision floating-point standard:
@@ -3,17 +3,23 @@
 #include <string>
 
 #include "DwarfDebug.hpp"
+#include "../ProcessTracer.hpp"
 
 class ValueDeducer
 {
 public:
-	ValueDeducer(pid_t target_pid, std::shared_ptr<DwarfDebug> debug_data);
+	// Types are looked up through the reader of the compilation unit which
+	// declared the value
+	ValueDeducer(ProcessTracer &tracer, std::shared_ptr<DwarfInfoReader> debug_info);
 
 	std::string deduce(uint64_t address, DIE &die);
 
 private:
-	pid_t target_pid;
-	std::shared_ptr<DwarfDebug> debug_data;
+	ProcessTracer &tracer;
+	std::shared_ptr<DwarfInfoReader> debug_info;
+
+	// Reads up to 8 bytes of the target's memory, zero-extended
+	expected<uint64_t, std::string> readData(uint64_t address, uint64_t byte_size);
 
 	std::string deduceBase(uint64_t address, const DIE &base_die);
 	std::string deducePointer(uint64_t address, const DIE &pointer_die);
@@ -23,6 +29,8 @@ private:
 	std::string deduceClass(uint64_t address, DIE &class_die);
 	std::string deduceConst(uint64_t address, const DIE &const_die);
 
+	std::string formatBase(uint64_t data, const DIE &base_die);
+
 	float decodeFloat(uint64_t data);
 	double decodeDouble(uint64_t data);
 };
\ No newline at end of file
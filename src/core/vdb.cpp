@@ -8,6 +8,7 @@
 #include <stdio.h>
 
 #include "dwarf/DwarfDebug.hpp"
+#include "dwarf/IndexCache.hpp"
 #include <cstring>
 
 // TODO: Move this function to its own dedicated file
@@ -47,11 +48,23 @@ bool VDB::init(const char *executable_name)
 	if (!isExecutableFile(executable_name))
 		return false;
 
-	// Create the DWARF debug data for this target executable
-	debug_info = DebugInfo::readFrom(executable_name);
+	// Create the DWARF debug data for this target executable, reusing the
+	// indices from the last time it was loaded if it hasn't changed. If they
+	// have to be built, it is done in the background, and the progress is
+	// posted to the engine.
+	auto index_progress = std::make_shared<ThreadSafeQueue<IndexProgressMessage>>();
+	auto progress = [index_progress](size_t indexed_units, size_t total_units)
+	{
+		auto progress_msg = std::make_unique<IndexProgressMessage>();
+		progress_msg->indexed_units = indexed_units;
+		progress_msg->total_units = total_units;
+		index_progress->push(std::move(progress_msg));
+	};
+	debug_info = DebugInfo::readFrom(executable_name, DebugInfo::LOAD_BACKGROUND,
+	                                 IndexCache::defaultDirectory(), progress);
 
 	// Create the debug engine for debugging the target executable
-	engine = std::make_shared<DebugEngine>(executable_name, debug_info);
+	engine = std::make_shared<DebugEngine>(executable_name, debug_info, index_progress);
 
 	is_initialized = true;
 
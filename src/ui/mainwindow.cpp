@@ -3,6 +3,7 @@
 
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QStatusBar>
 #include <QTextStream>
 #include <QFile>
 
@@ -37,8 +38,26 @@ MainWindow::~MainWindow()
 
 void MainWindow::pollDebugEngine()
 {
-    std::unique_ptr<DebugMessage> msg = vdb->getDebugEngine()->tryPoll();
-    if (msg != nullptr)
+    // Indexing progress can arrive in bursts, so every waiting message is
+    // handled at once
+    std::unique_ptr<IndexProgressMessage> progress_msg = nullptr;
+    while ((progress_msg = vdb->getDebugEngine()->tryPollIndexProgress()) != nullptr)
+    {
+        // Nothing waits for indexing to finish, so this is only shown
+        if (progress_msg->indexed_units < progress_msg->total_units)
+        {
+            statusBar()->showMessage(tr("Indexing debug information: %1 of %2 compilation units")
+                                     .arg(progress_msg->indexed_units)
+                                     .arg(progress_msg->total_units));
+        }
+        else
+        {
+            statusBar()->showMessage(tr("Debug information indexed"), 5000);
+        }
+    }
+
+    std::unique_ptr<DebugMessage> msg = nullptr;
+    while ((msg = vdb->getDebugEngine()->tryPoll()) != nullptr)
     {
         GetValueMessage *value_msg = dynamic_cast<GetValueMessage *>(msg.get());
         if (value_msg != nullptr)
@@ -127,7 +146,8 @@ void MainWindow::importExecutable()
     // Check if the file is executable
     if (!QFileInfo(filename).isExecutable()) return;
 
-    // Create the debugger
+    // Create the debugger. The debug information is indexed in the
+    // background, so this only waits for the compilation units to be listed.
     vdb->init(filename.toStdString().c_str());
 
     // Clear the files window
@@ -137,6 +157,10 @@ void MainWindow::importExecutable()
     std::shared_ptr<DebugInfo> debug_info = vdb->getDebugInfo();
     ui->fileTreeWidget->populate(debug_info->getSourceFiles());
 
+    // Start polling for the progress of indexing. Breakpoints can be set, and
+    // debugging started, before it has finished.
+    timer->start(500);
+
     // Enable the debugging button once the executable's source is loaded
     setDebugButtonEnabled(true);
 }
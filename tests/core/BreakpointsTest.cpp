@@ -49,4 +49,70 @@ TEST_CASE("Breakpoint testing")
 		REQUIRE(bph_msg->file_name == source_file);
 		REQUIRE(bph_msg->line_number == source_line);
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Breakpoint on a function by name is hit")
+{
+	VDB vdb;
+	vdb.init("data/functions");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+
+	REQUIRE(engine->addFunctionBreakpoint("branchedReturn"));
+	REQUIRE(!engine->addFunctionBreakpoint("missingFunction"));
+
+	// The breakpoint is on the line the function starts at
+	engine->run();
+	std::unique_ptr<DebugMessage> msg = nullptr;
+	while ((msg = engine->tryPoll()) == nullptr) {}
+
+	BreakpointHitMessage *bph_msg = dynamic_cast<BreakpointHitMessage *>(msg.get());
+	REQUIRE(bph_msg != nullptr);
+	REQUIRE(bph_msg->file_name == std::string(VDB_TEST_DIR) + "/data/functions.cpp");
+	REQUIRE(bph_msg->line_number == 6);
+}
+
+TEST_CASE("Breakpoint in a shared library is hit")
+{
+	VDB vdb;
+	vdb.init("data/use_library");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+
+	// The library's lines are only found once it has been loaded
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/library.cpp";
+	const unsigned int source_line = 5;
+	engine->addBreakpoint(source_file.c_str(), source_line);
+
+	engine->run();
+	std::unique_ptr<DebugMessage> msg = nullptr;
+	while ((msg = engine->tryPoll()) == nullptr) {}
+
+	BreakpointHitMessage *bph_msg = dynamic_cast<BreakpointHitMessage *>(msg.get());
+	REQUIRE(bph_msg != nullptr);
+	REQUIRE(bph_msg->file_name == source_file);
+	REQUIRE(bph_msg->line_number == source_line);
+}
+
+TEST_CASE("Breakpoint in a shared library loaded at runtime is hit")
+{
+	VDB vdb;
+	vdb.init("data/open_library");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+
+	// The library is opened by the target after it has started, so its
+	// breakpoints are enabled when the rendezvous breakpoint reports it
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/library.cpp";
+	const unsigned int source_line = 5;
+	engine->addBreakpoint(source_file.c_str(), source_line);
+
+	engine->run();
+	std::unique_ptr<DebugMessage> msg = nullptr;
+	while ((msg = engine->tryPoll()) == nullptr) {}
+
+	BreakpointHitMessage *bph_msg = dynamic_cast<BreakpointHitMessage *>(msg.get());
+	REQUIRE(bph_msg != nullptr);
+	REQUIRE(bph_msg->file_name == source_file);
+	REQUIRE(bph_msg->line_number == source_line);
+}
@@ -0,0 +1,378 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+#include "DebugInfo.hpp"
+#include "ELFFile.hpp"
+#include "dwarf/DebugFileLocator.hpp"
+#include "dwarf/DwarfDebug.hpp"
+#include "dwarf/IndexCache.hpp"
+
+uint64_t addressOf(std::shared_ptr<DebugInfo> debug_info, const std::string& source_file, uint64_t line_number)
+{
+	for (const auto& line : debug_info->getSourceFileLines(source_file))
+	{
+		if (line.number == line_number)
+			return line.address;
+	}
+	return 0;
+}
+
+TEST_CASE("Function lookup by address")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions");
+
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/functions.cpp";
+
+	SECTION("Address within a function resolves to that function")
+	{
+		uint64_t address = addressOf(debug_info, source_file, 3);
+		REQUIRE(address != 0);
+
+		auto function = debug_info->getFunction(address);
+		REQUIRE(function.has_value());
+		REQUIRE(function.value().name == "branchlessReturn");
+		REQUIRE(function.value().decl_file == source_file);
+		REQUIRE(function.value().decl_line == 1);
+		REQUIRE(function.value().start_address <= address);
+		REQUIRE(function.value().end_address > address);
+	}
+
+	SECTION("Every address within a function resolves to the same function")
+	{
+		uint64_t address = addressOf(debug_info, source_file, 17);
+		REQUIRE(address != 0);
+
+		auto function = debug_info->getFunction(address);
+		REQUIRE(function.has_value());
+		REQUIRE(function.value().name == "recursive");
+		for (uint64_t addr = function.value().start_address; addr < function.value().end_address; addr++)
+			REQUIRE(debug_info->getFunction(addr).value().name == "recursive");
+	}
+
+	SECTION("Address outside of any function fails to resolve")
+	{
+		REQUIRE(!debug_info->getFunction(0).has_value());
+	}
+}
+
+TEST_CASE("Function lookup by name")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions");
+
+	SECTION("Defined function resolves to its address range")
+	{
+		auto function = debug_info->getFunctionByName("branchedReturn");
+		REQUIRE(function.has_value());
+		REQUIRE(function.value().name == "branchedReturn");
+		REQUIRE(function.value().decl_line == 6);
+		REQUIRE(function.value().start_address < function.value().end_address);
+	}
+
+	SECTION("Unknown function fails to resolve")
+	{
+		REQUIRE(!debug_info->getFunctionByName("missingFunction").has_value());
+	}
+
+	SECTION("Code of a function is read from the mapped executable")
+	{
+		auto function = debug_info->getFunctionByName("main");
+		REQUIRE(function.has_value());
+
+		std::shared_ptr<ELFFile> elf_file = debug_info->getELFFile();
+		REQUIRE(elf_file != nullptr);
+
+		auto bytes = elf_file->bytesAtAddress(function.value().start_address, 4);
+		REQUIRE(bytes.has_value());
+		REQUIRE(bytes.value().size == 4);
+	}
+}
+
+TEST_CASE("Function lookup by qualified name")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/methods");
+
+	SECTION("Member function defined out of line resolves through its declaration")
+	{
+		auto function = debug_info->getFunctionByName("shapes::Square::area");
+		REQUIRE(function.has_value());
+		REQUIRE(function.value().name == "area");
+		REQUIRE(function.value().decl_line == 7);
+		REQUIRE(function.value().start_address < function.value().end_address);
+	}
+
+	SECTION("Constructor resolves through its abstract instance")
+	{
+		auto function = debug_info->getFunctionByName("shapes::Square::Square");
+		REQUIRE(function.has_value());
+		REQUIRE(function.value().decl_line == 6);
+	}
+
+	SECTION("Unqualified member function fails to resolve")
+	{
+		REQUIRE(!debug_info->getFunctionByName("area").has_value());
+	}
+}
+
+// Only some toolchains can write the name indices, so their fixtures may not
+// have been built
+void requireNameTableLookup(const std::string& executable, const std::string& section_name)
+{
+	if (access(executable.c_str(), R_OK) != 0)
+	{
+		WARN(executable << " wasn't built, so " << section_name << " isn't tested");
+		return;
+	}
+
+	DwarfDebug dwarf(executable);
+	std::shared_ptr<DwarfInfoReader> info = dwarf.info();
+	REQUIRE(info->getNameTable() != nullptr);
+	REQUIRE(std::string(info->getNameTable()->getSectionName()) == section_name);
+	REQUIRE(info->findCompileUnitsByName("branchedReturn").size() == 1);
+	REQUIRE(info->findCompileUnitsByName("missingFunction").empty());
+
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom(executable, DebugInfo::LOAD_LAZY);
+	auto function = debug_info->getFunctionByName("branchedReturn");
+	REQUIRE(function.has_value());
+	REQUIRE(function.value().decl_line == 6);
+	REQUIRE(!debug_info->getFunctionByName("missingFunction").has_value());
+}
+
+TEST_CASE("Names are looked up through the index written by the toolchain")
+{
+	requireNameTableLookup("data/functions_gdb_index", ".gdb_index");
+	requireNameTableLookup("data/functions_debug_names", ".debug_names");
+}
+
+TEST_CASE("Line lookup by address")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions");
+
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/functions.cpp";
+
+	SECTION("Address of a line row resolves to that line")
+	{
+		uint64_t address = addressOf(debug_info, source_file, 23);
+		REQUIRE(address != 0);
+
+		auto line = debug_info->getLine(address);
+		REQUIRE(line.has_value());
+		REQUIRE(line.value().number == 23);
+		REQUIRE(line.value().address == address);
+		REQUIRE(debug_info->getSourcePath(line.value().file) == source_file);
+	}
+
+	SECTION("Address between line rows resolves to the preceding row")
+	{
+		uint64_t address = addressOf(debug_info, source_file, 23);
+		uint64_t next_address = addressOf(debug_info, source_file, 24);
+		REQUIRE(address != 0);
+		REQUIRE(next_address > address + 1);
+
+		auto line = debug_info->getLine(address + 1);
+		REQUIRE(line.has_value());
+		REQUIRE(line.value().number == 23);
+		REQUIRE(line.value().address == address);
+	}
+
+	SECTION("Function lines are confined to the function")
+	{
+		uint64_t address = addressOf(debug_info, source_file, 3);
+		auto function = debug_info->getFunction(address);
+		REQUIRE(function.has_value());
+
+		auto lines = debug_info->getFunctionLines(address);
+		REQUIRE(!lines.empty());
+		for (const auto& line : lines)
+		{
+			REQUIRE(line.address >= function.value().start_address);
+			REQUIRE(line.address < function.value().end_address);
+		}
+	}
+
+	SECTION("Lines refer to their source file by a shared ID")
+	{
+		auto file_id = debug_info->getSourcePathId(source_file);
+		REQUIRE(file_id.has_value());
+		REQUIRE(debug_info->getSourcePath(file_id.value()) == source_file);
+
+		// Function lines are a view of the same table as the file's lines
+		auto file_lines = debug_info->getSourceFileLines(source_file);
+		auto function_lines = debug_info->getFunctionLines(addressOf(debug_info, source_file, 3));
+		REQUIRE(!function_lines.empty());
+		REQUIRE(function_lines.begin() >= file_lines.begin());
+		REQUIRE(function_lines.end() <= file_lines.end());
+		for (const auto& line : function_lines)
+			REQUIRE(line.file == file_id.value());
+	}
+}
+
+// Checks that debug information read in another mode, or from another build
+// of the same program, gives the same answers as the default, fully indexed
+// mode
+static void requireMatchesIndexed(DebugInfo::LoadMode mode, const std::string &cache_directory = "",
+                                  const std::string &executable_name = "data/functions")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions");
+	std::shared_ptr<DebugInfo> other_debug_info = DebugInfo::readFrom(executable_name, mode,
+	                                                                  cache_directory);
+
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/functions.cpp";
+
+	REQUIRE(other_debug_info->getSourceFiles() == debug_info->getSourceFiles());
+
+	auto lines = debug_info->getSourceFileLines(source_file);
+	auto other_lines = other_debug_info->getSourceFileLines(source_file);
+	REQUIRE(!lines.empty());
+	REQUIRE(other_lines.size() == lines.size());
+
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		REQUIRE(other_lines[i].number == lines[i].number);
+		REQUIRE(other_lines[i].address == lines[i].address);
+
+		auto function = debug_info->getFunction(lines[i].address);
+		auto other_function = other_debug_info->getFunction(lines[i].address);
+		REQUIRE(other_function.has_value() == function.has_value());
+		if (function.has_value())
+		{
+			REQUIRE(other_function.value().name == function.value().name);
+			REQUIRE(other_function.value().start_address == function.value().start_address);
+			REQUIRE(other_function.value().end_address == function.value().end_address);
+			REQUIRE(other_function.value().decl_line == function.value().decl_line);
+		}
+	}
+}
+
+TEST_CASE("Flattened debug information matches libdwarf")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_FLATTENED);
+}
+
+TEST_CASE("Lazily loaded debug information matches eager indexing")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_LAZY);
+}
+
+TEST_CASE("Debug information indexed in the background matches eager indexing")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_BACKGROUND);
+
+	std::atomic<size_t> indexed_units(0);
+	std::atomic<size_t> total_units(0);
+	auto progress = [&](size_t indexed, size_t total)
+	{
+		indexed_units = indexed;
+		total_units = total;
+	};
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions", DebugInfo::LOAD_BACKGROUND,
+	                                                            "", progress);
+	debug_info->waitUntilIndexed();
+	REQUIRE(total_units > 0);
+	REQUIRE(indexed_units == total_units);
+	REQUIRE(debug_info->getFunctionByName("branchedReturn").has_value());
+}
+
+TEST_CASE("Debug information of a shared object is read once and shared")
+{
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readShared("data/liblibrary.so");
+	REQUIRE(debug_info != nullptr);
+	REQUIRE(DebugInfo::readShared("data/liblibrary.so") == debug_info);
+
+	auto function = debug_info->getFunctionByName("getLibraryValue");
+	REQUIRE(function.has_value());
+	REQUIRE(function.value().decl_line == 3);
+
+	REQUIRE(DebugInfo::readShared("data/missing_library.so") == nullptr);
+}
+
+TEST_CASE("Compressed debug information matches uncompressed")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_INDEXED, "", "data/functions_compressed");
+	requireMatchesIndexed(DebugInfo::LOAD_LAZY, "", "data/functions_compressed");
+}
+
+TEST_CASE("Debug information of a stripped executable is read from its debug file")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_INDEXED, "", "data/functions_stripped");
+}
+
+TEST_CASE("Debug file candidates which aren't ELF objects are skipped")
+{
+	REQUIRE(!ELFFile::open("data/functions_bad_link.debug").has_value());
+
+	// The executable is all there is to read, though it has no DWARF
+	auto executable = ELFFile::open("data/functions_bad_link");
+	REQUIRE(executable.has_value());
+	REQUIRE(DebugFileLocator().locate(executable.value()) == executable.value());
+}
+
+TEST_CASE("Split debug information matches unsplit")
+{
+	requireMatchesIndexed(DebugInfo::LOAD_INDEXED, "", "data/functions_split");
+	requireMatchesIndexed(DebugInfo::LOAD_LAZY, "", "data/functions_split");
+
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom("data/functions_split");
+	auto function = debug_info->getFunctionByName("branchedReturn");
+	REQUIRE(function.has_value());
+	REQUIRE(function.value().decl_line == 6);
+}
+
+void requireSplitMatchesUnsplit(const std::string &executable)
+{
+	requireMatchesIndexed(DebugInfo::LOAD_INDEXED, "", executable);
+	requireMatchesIndexed(DebugInfo::LOAD_LAZY, "", executable);
+
+	std::shared_ptr<DebugInfo> debug_info = DebugInfo::readFrom(executable);
+	auto function = debug_info->getFunctionByName("branchedReturn");
+	REQUIRE(function.has_value());
+	REQUIRE(function.value().decl_line == 6);
+}
+
+TEST_CASE("Split debug information in a package matches unsplit")
+{
+	// The fixtures are only built where a dwp tool was found which can pack
+	// their units
+	SECTION("DWARF4")
+	{
+		if (access("data/functions_package.dwp", R_OK) != 0)
+			WARN("No DWARF4 .dwp fixture was built");
+		else
+			requireSplitMatchesUnsplit("data/functions_package");
+	}
+
+	SECTION("DWARF5")
+	{
+		if (access("data/functions_package5.dwp", R_OK) != 0)
+			WARN("No DWARF5 .dwp fixture was built");
+		else
+			requireSplitMatchesUnsplit("data/functions_package5");
+	}
+}
+
+TEST_CASE("DWARF5 split debug information matches unsplit")
+{
+	requireSplitMatchesUnsplit("data/functions_split5");
+}
+
+TEST_CASE("Debug information loaded from the index cache matches eager indexing")
+{
+	char cache_directory[] = "/tmp/vdb_index_cache_XXXXXX";
+	REQUIRE(mkdtemp(cache_directory) != nullptr);
+	IndexCache cache(ELFFile("data/functions"), cache_directory);
+
+	// The first read builds the indices and writes the cache, which the
+	// second read then loads
+	DebugInfo::readFrom("data/functions", DebugInfo::LOAD_INDEXED, cache_directory);
+	REQUIRE(access(cache.path().c_str(), R_OK) == 0);
+	REQUIRE(cache.load().has_value());
+	requireMatchesIndexed(DebugInfo::LOAD_INDEXED, cache_directory);
+
+	unlink(cache.path().c_str());
+	rmdir(cache_directory);
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <csignal>
+#include <cstring>
+#include <string>
+
+#include <sys/wait.h>
+
+#include "ProcessTracer.hpp"
+
+TEST_CASE("Tracee memory reads")
+{
+	// The tracee is stopped on its first instruction, with its arguments at
+	// the top of its stack
+	const std::string executable = "data/hello_world";
+	ProcessTracer tracer;
+	REQUIRE(tracer.start(executable));
+
+	auto regs = tracer.getRegisters();
+	REQUIRE(regs.has_value());
+	uint64_t stack_pointer = regs.value().rsp;
+
+	SECTION("Memory is read in bulk")
+	{
+		uint64_t stack[2] = {0, 0};
+		REQUIRE(tracer.readMemory(stack_pointer, stack, sizeof(stack)).has_value());
+		REQUIRE(stack[0] == 1);
+		REQUIRE(stack[0] == tracer.peekText(stack_pointer).value());
+		REQUIRE(stack[1] == tracer.peekText(stack_pointer + sizeof(uint64_t)).value());
+	}
+
+	SECTION("Scattered regions are read together")
+	{
+		uint64_t argc = 0;
+		uint64_t argv0 = 0;
+		REQUIRE(tracer.readMemory({
+			{stack_pointer + sizeof(uint64_t), &argv0, sizeof(argv0)},
+			{stack_pointer, &argc, sizeof(argc)}
+		}).has_value());
+		REQUIRE(argc == 1);
+
+		auto name = tracer.readString(argv0);
+		REQUIRE(name.has_value());
+		REQUIRE(name.value() == executable);
+	}
+
+	SECTION("Pages are cached until the tracee is resumed or written")
+	{
+		uint64_t argc = 0;
+		REQUIRE(tracer.readMemory(stack_pointer, &argc, sizeof(argc)).has_value());
+		ProcessTracer::MemoryCacheStats stats = tracer.memoryCacheStats();
+		REQUIRE(tracer.readMemory(stack_pointer, &argc, sizeof(argc)).has_value());
+		REQUIRE(tracer.memoryCacheStats().hits == stats.hits + 1);
+		REQUIRE(tracer.memoryCacheStats().misses == stats.misses);
+
+		// Writes are seen by the next read
+		REQUIRE(tracer.pokeText(stack_pointer, 2).has_value());
+		REQUIRE(tracer.readMemory(stack_pointer, &argc, sizeof(argc)).has_value());
+		REQUIRE(argc == 2);
+		REQUIRE(tracer.memoryCacheStats().misses == stats.misses + 1);
+
+		stats = tracer.memoryCacheStats();
+		REQUIRE(tracer.singleStepExec().has_value());
+		REQUIRE(tracer.readMemory(stack_pointer, &argc, sizeof(argc)).has_value());
+		REQUIRE(tracer.memoryCacheStats().misses == stats.misses + 1);
+	}
+
+	SECTION("Memory is written, including read-only code")
+	{
+		uint64_t instruction_pointer = regs.value().rip;
+		uint8_t original[4];
+		REQUIRE(tracer.readMemory(instruction_pointer, original, sizeof(original)).has_value());
+
+		const uint8_t traps[4] = {0xCC, 0xCC, 0xCC, 0xCC};
+		REQUIRE(tracer.writeMemory(instruction_pointer, traps, sizeof(traps)).has_value());
+		uint8_t written[4];
+		REQUIRE(tracer.readMemory(instruction_pointer, written, sizeof(written)).has_value());
+		REQUIRE(memcmp(written, traps, sizeof(traps)) == 0);
+
+		REQUIRE(tracer.writeMemory(instruction_pointer, original, sizeof(original)).has_value());
+		REQUIRE((tracer.peekText(instruction_pointer).value() & 0xFFFFFFFF) ==
+		        (original[0] | original[1] << 8 | original[2] << 16 | static_cast<uint64_t>(original[3]) << 24));
+	}
+
+	SECTION("Registers are written back when flushed")
+	{
+		user_regs_struct regs = tracer.getRegisters().value();
+		regs.r15 = 0x1234;
+		REQUIRE(tracer.setRegisters(regs).has_value());
+		REQUIRE(tracer.getRegisters().value().r15 == 0x1234);
+
+		user_regs_struct traced_regs;
+		REQUIRE(ptrace(PTRACE_GETREGS, tracer.traceePID(), 0, &traced_regs) != -1);
+		REQUIRE(traced_regs.r15 != 0x1234);
+
+		REQUIRE(tracer.flushRegisters().has_value());
+		REQUIRE(ptrace(PTRACE_GETREGS, tracer.traceePID(), 0, &traced_regs) != -1);
+		REQUIRE(traced_regs.r15 == 0x1234);
+		REQUIRE(tracer.getFloatingPointRegisters().has_value());
+	}
+
+	SECTION("Memory is still written after the tracer is moved, even into itself")
+	{
+		ProcessTracer moved;
+		moved = std::move(tracer);
+		ProcessTracer &same = moved;
+		moved = std::move(same);
+
+		uint64_t instruction_pointer = regs.value().rip;
+		uint8_t original = 0;
+		REQUIRE(moved.readMemory(instruction_pointer, &original, sizeof(original)).has_value());
+		REQUIRE(moved.writeMemory(instruction_pointer, &original, sizeof(original)).has_value());
+	}
+
+	SECTION("Unmapped memory fails to read")
+	{
+		uint64_t data;
+		REQUIRE(!tracer.readMemory(0, &data, sizeof(data)).has_value());
+		REQUIRE(!tracer.readString(0).has_value());
+	}
+
+	kill(tracer.traceePID(), SIGKILL);
+	waitpid(tracer.traceePID(), nullptr, 0);
+}
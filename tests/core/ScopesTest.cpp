@@ -0,0 +1,91 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <memory>
+
+#include "vdb.hpp"
+
+std::string valueOf(const std::string& variable_name, std::shared_ptr<DebugEngine> engine)
+{
+	std::unique_ptr<GetValueMessage> get_val = std::unique_ptr<GetValueMessage>(new GetValueMessage());
+	get_val->variable_name = variable_name;
+	engine->sendMessage(std::move(get_val));
+
+	std::unique_ptr<DebugMessage> ret_val = nullptr;
+	while ((ret_val = engine->tryPoll()) == nullptr) {}
+
+	GetValueMessage *value_msg = dynamic_cast<GetValueMessage *>(ret_val.get());
+	if (value_msg != nullptr)
+	{
+		return value_msg->value;
+	}
+	else
+	{
+		return "";
+	}
+}
+
+void runToLine(std::shared_ptr<DebugEngine> engine, unsigned int source_line)
+{
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/scopes.cpp";
+
+	// Set the breakpoint
+	engine->addBreakpoint(source_file.c_str(), source_line);
+
+	// Run the target process until it encounters the breakpoint
+	engine->run();
+	std::unique_ptr<DebugMessage> msg = nullptr;
+	while ((msg = engine->tryPoll()) == nullptr) {}
+}
+
+TEST_CASE("Variable lookup within the innermost lexical block")
+{
+	VDB vdb;
+	vdb.init("data/scopes");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+	runToLine(engine, 12);
+
+	SECTION("Innermost declaration shadows enclosing declarations")
+	{
+		REQUIRE(valueOf("value", engine) == "6");
+	}
+
+	SECTION("Variables of enclosing scopes remain visible")
+	{
+		REQUIRE(valueOf("outer", engine) == "3");
+	}
+
+	SECTION("Global variables remain visible")
+	{
+		REQUIRE(valueOf("global_value", engine) == "1");
+	}
+}
+
+TEST_CASE("Variable lookup within an enclosing lexical block")
+{
+	VDB vdb;
+	vdb.init("data/scopes");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+	runToLine(engine, 14);
+
+	SECTION("Declaration in the enclosing block is used")
+	{
+		REQUIRE(valueOf("value", engine) == "5");
+	}
+}
+
+TEST_CASE("Variable lookup within a function scope")
+{
+	VDB vdb;
+	vdb.init("data/scopes");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+	runToLine(engine, 16);
+
+	SECTION("Local declaration shadows the global declaration")
+	{
+		REQUIRE(valueOf("value", engine) == "4");
+	}
+}
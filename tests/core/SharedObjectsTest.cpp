@@ -0,0 +1,65 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include <csignal>
+#include <string>
+
+#include <sys/wait.h>
+
+#include "Breakpoint.hpp"
+#include "ELFFile.hpp"
+#include "ProcessMemoryMappings.hpp"
+#include "ProcessTracer.hpp"
+#include "SharedObjectObserver.hpp"
+
+bool isLibrary(const SharedObject& object)
+{
+	const std::string name = "liblibrary.so";
+	return object.path.size() >= name.size() &&
+	       object.path.compare(object.path.size() - name.size(), name.size(), name) == 0;
+}
+
+TEST_CASE("Shared objects are tracked through the rendezvous breakpoint")
+{
+	const std::string executable = "data/use_library";
+	ProcessTracer tracer;
+	REQUIRE(tracer.start(executable));
+	ELFFile elf_file(executable);
+	ProcessMemoryMappings memory_mappings(tracer.traceePID());
+
+	// The dynamic linker has loaded the libraries by the time the entry point
+	// is reached
+	uint64_t entry_address = elf_file.entryPoint();
+	if (elf_file.hasPositionIndependentCode())
+		entry_address += memory_mappings.loadAddress();
+	Breakpoint entry_breakpoint(entry_address);
+	entry_breakpoint.enable(tracer);
+	REQUIRE(tracer.continueExec().has_value());
+
+	SharedObjectObserver observer;
+	REQUIRE(observer.setRendezvousBreakpoint(tracer, elf_file, memory_mappings));
+
+	SECTION("Libraries loaded before the entry point are reported once")
+	{
+		auto events = observer.update(tracer, elf_file, memory_mappings);
+		bool is_library_loaded = false;
+		for (const auto& event : events)
+		{
+			REQUIRE(event.type == SharedObjectEvent::LOADED);
+			if (isLibrary(event.object))
+			{
+				is_library_loaded = true;
+				REQUIRE(event.object.base_address != 0);
+			}
+		}
+		REQUIRE(is_library_loaded);
+		REQUIRE(observer.getLoadedObjects().size() == events.size());
+
+		// Nothing has changed since
+		REQUIRE(observer.update(tracer, elf_file, memory_mappings).empty());
+		REQUIRE(observer.getLoadedObjects().size() == events.size());
+	}
+
+	kill(tracer.traceePID(), SIGKILL);
+	waitpid(tracer.traceePID(), nullptr, 0);
+}
@@ -66,4 +66,37 @@ TEST_CASE("Source step into")
 		REQUIRE(msg->line_number == 15);
 		REQUIRE(msg->file_name == source_file);
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("Source step into a shared library")
+{
+	VDB vdb;
+	vdb.init("data/use_library");
+
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/use_library.cpp";
+	const std::string library_file = std::string(VDB_TEST_DIR) + "/data/library.cpp";
+
+	SECTION("Call through the PLT steps into the library function")
+	{
+		auto msg = stepInto(vdb, source_file, 5);
+		REQUIRE(msg != nullptr);
+		REQUIRE(msg->line_number == 4);
+		REQUIRE(msg->file_name == library_file);
+	}
+}
+
+TEST_CASE("Source step into a function without lines")
+{
+	VDB vdb;
+	vdb.init("data/hello_world");
+
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/hello_world.cpp";
+
+	SECTION("Call into an undebugged shared object returns to the caller")
+	{
+		auto msg = stepInto(vdb, source_file, 5);
+		REQUIRE(msg != nullptr);
+		REQUIRE(msg->line_number == 5);
+		REQUIRE(msg->file_name == source_file);
+	}
+}
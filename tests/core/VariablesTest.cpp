@@ -90,4 +90,24 @@ TEST_CASE("Fundamental type value deduction")
 		REQUIRE(std::stod(valueOf("d", engine)) == 30.0);
 		// REQUIRE(std::stold(valueOf("l_d", engine)) == 31.0);
 	}
-}
\ No newline at end of file
+}
+TEST_CASE("Global of a shared library is read while stopped in it")
+{
+	VDB vdb;
+	vdb.init("data/use_library");
+
+	std::shared_ptr<DebugEngine> engine = vdb.getDebugEngine();
+
+	// Stop in the library, after its constructor has set the global
+	const std::string source_file = std::string(VDB_TEST_DIR) + "/data/library.cpp";
+	const unsigned int source_line = 5;
+	engine->addBreakpoint(source_file.c_str(), source_line);
+
+	engine->run();
+	std::unique_ptr<DebugMessage> msg = nullptr;
+	while ((msg = engine->tryPoll()) == nullptr) {}
+
+	// The global's address is relative to where the library was linked, so
+	// it is only found if moved to where the library was loaded
+	REQUIRE(valueOf("library_value", engine) == "10");
+}
@@ -0,0 +1,27 @@
+namespace shapes
+{
+	class Square
+	{
+	public:
+		Square(int side);
+		int area() const;
+
+	private:
+		int side;
+	};
+
+	Square::Square(int side) : side(side)
+	{
+	}
+
+	int Square::area() const
+	{
+		return side * side;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	shapes::Square square(3);
+	return square.area();
+}
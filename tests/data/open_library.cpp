@@ -0,0 +1,16 @@
+#include <dlfcn.h>
+
+int main(int argc, char* argv[])
+{
+	// The library is loaded once the program is running, rather than by the
+	// dynamic linker before it starts
+	void* library = dlopen(LIBRARY_PATH, RTLD_NOW);
+	if (library == nullptr)
+		return 1;
+
+	// getLibraryValue(), by its mangled name
+	auto getLibraryValue = reinterpret_cast<int (*)()>(dlsym(library, "_Z15getLibraryValuev"));
+	int value = (getLibraryValue != nullptr) ? getLibraryValue() : 0;
+	dlclose(library);
+	return 0;
+}
\ No newline at end of file
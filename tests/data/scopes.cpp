@@ -0,0 +1,17 @@
+int global_value = 1;
+int value = 2;
+
+int main(int argc, char* argv[])
+{
+	int outer = 3;
+	int value = 4;
+	{
+		int value = 5;
+		{
+			int value = 6;
+			outer = value;
+		}
+		outer = value;
+	}
+	return outer + value + global_value;
+}